@@ -0,0 +1,816 @@
+#include "Benchmark.hpp"
+#include "Containers.hpp"
+#include "Obstacles.hpp"
+#include "FlowField.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <iostream>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+
+namespace
+{
+struct Scenario
+{
+  const char* name {};
+  void (*configure)( SimulationConfig& ) {};
+};
+
+
+constexpr std::size_t SceneObstaclesPerAxis {4};
+
+using SceneObstacleArray = std::array <Obstacle,
+  SceneObstaclesPerAxis * SceneObstaclesPerAxis * SceneObstaclesPerAxis>;
+
+//  a lattice cycling through the obstacle types, fixed
+//  so the scene scenario's baseline can't drift
+SceneObstacleArray
+makeSceneObstacles()
+{
+  SceneObstacleArray obstacles {};
+
+  constexpr Vector3 extent {0.01f, 0.005f, 0.015f};
+
+  for ( std::size_t i {}; i < obstacles.size(); ++i )
+  {
+    auto& obstacle = obstacles[i];
+
+    const Vector3 center
+    {
+      (i % SceneObstaclesPerAxis + 0.5f) / SceneObstaclesPerAxis,
+      (i / SceneObstaclesPerAxis % SceneObstaclesPerAxis + 0.5f) / SceneObstaclesPerAxis,
+      (i / SceneObstaclesPerAxis / SceneObstaclesPerAxis + 0.5f) / SceneObstaclesPerAxis,
+    };
+
+    obstacle.type = static_cast <Obstacle::Type> (i % 3);
+    obstacle.radius = 0.01f;
+
+    switch (obstacle.type)
+    {
+      case Obstacle::Type::Sphere:
+        obstacle.a = center;
+        break;
+
+      case Obstacle::Type::Capsule:
+      case Obstacle::Type::Box:
+        obstacle.a = center - extent;
+        obstacle.b = center + extent;
+        break;
+    }
+  }
+
+  return obstacles;
+}
+
+const SceneObstacleArray SceneObstacles = makeSceneObstacles();
+
+//  the repulsor is dynamic, so it's splatted every frame
+const FlowSource SceneFlowSources []
+{
+  {
+    {0.5f, 0.5f, 0.5f}, {1.f, 0.f, 0.f},
+    0.5f, 0.05f,
+    FlowSource::Type::Wind, true,
+  },
+  {
+    {0.4f, 0.4f, 0.4f}, {0.6f, 0.6f, 0.6f},
+    0.1f, 1.f,
+    FlowSource::Type::NoFly, true,
+  },
+  {
+    {0.25f, 0.75f, 0.5f}, {},
+    0.3f, 0.2f,
+    FlowSource::Type::Attractor, true,
+  },
+  {
+    {0.5f, 0.8f, 0.8f}, {},
+    0.2f, 1.f,
+    FlowSource::Type::Repulsor, false,
+  },
+};
+
+const Scenario Scenarios []
+{
+  {"grid",
+    [] ( SimulationConfig& ) {}},
+
+  {"stencil",
+    [] ( SimulationConfig& config )
+    {
+      config.stencilRadius = 1;
+    }},
+
+  {"periodic",
+    [] ( SimulationConfig& config )
+    {
+      config.boundary = BoundaryMode::Periodic;
+    }},
+
+  {"octree",
+    [] ( SimulationConfig& config )
+    {
+      config.spatialIndex = SpatialIndex::Octree;
+    }},
+
+  {"incremental",
+    [] ( SimulationConfig& config )
+    {
+      config.incrementalBinning = true;
+    }},
+
+  {"pipelined",
+    [] ( SimulationConfig& config )
+    {
+      config.pipelineDepth = 2;
+    }},
+
+  {"scene",
+    [] ( SimulationConfig& config )
+    {
+      config.speciesCount = 3;
+      config.obstacles = {SceneObstacles.data(), SceneObstacles.size()};
+      config.flowSources = {SceneFlowSources, std::size(SceneFlowSources)};
+      config.temporalLod = true;
+    }},
+};
+
+constexpr std::size_t ScenarioCount {std::size(Scenarios)};
+
+constexpr std::size_t StageCount {Simulation::PerfMarker::Count};
+
+//  as they appear in baseline files, indexed by PerfMarker
+const char* const StageNames []
+{
+  "ResetTask",
+  "HashPosTask",
+  "Summing",
+  "NeighborStencil",
+  "RulesCalc",
+  "Transform",
+  "Rebin",
+  "Export",
+  "Total",
+  "ObstacleAvoidanceTask",
+  "FlowFieldTask",
+};
+
+static_assert(std::size(StageNames) == StageCount);
+
+const char BaselineMagic [] {"boids-perf-baseline"};
+constexpr int BaselineVersion {2};
+
+constexpr std::size_t HostNameLength {64};
+
+
+std::size_t
+findScenario(
+  const char* name )
+{
+  for ( std::size_t i {}; i < ScenarioCount; ++i )
+    if ( std::strcmp(Scenarios[i].name, name) == 0 )
+      return i;
+
+  return ScenarioCount;
+}
+
+std::size_t
+findStage(
+  const char* name )
+{
+  for ( std::size_t i {}; i < StageCount; ++i )
+    if ( std::strcmp(StageNames[i], name) == 0 )
+      return i;
+
+  return StageCount;
+}
+
+const char*
+scenarioName(
+  const std::size_t scenario )
+{
+  return Scenarios[scenario].name;
+}
+
+//  the machine a baseline was measured on, timings
+//  of different machines can't tell a regression
+void
+hostName(
+  char (&name) [HostNameLength] )
+{
+#if defined(_WIN32)
+  const auto computerName = std::getenv("COMPUTERNAME");
+
+  std::snprintf(
+    name, sizeof(name), "%s",
+    computerName != nullptr ? computerName : "unknown" );
+#else
+  if ( gethostname(name, sizeof(name) - 1) != 0 )
+    std::snprintf(name, sizeof(name), "unknown");
+#endif
+}
+
+
+//  Appends each stage's median frame time of one repetition to samples,
+//  frameTimes holds frameCount entries per stage
+bool
+runRepetition(
+  const SimulationConfig& simulationConfig,
+  const BenchmarkConfig& config,
+  Array <double>& frameTimes,
+  StageSamples* samples )
+{
+  Simulation simulation {};
+
+  if ( simulation.init(simulationConfig) == false )
+    return false;
+
+  simulation.stepN(config.warmupFrameCount, config.delta);
+
+  for ( std::size_t frame {}; frame < config.frameCount; ++frame )
+  {
+    simulation.step(config.delta);
+
+    for ( std::size_t stage {}; stage < StageCount; ++stage )
+      frameTimes[stage * config.frameCount + frame] =
+        std::chrono::duration_cast <double_us> (
+          simulation.timeCounter[stage].last ).count();
+  }
+
+  simulation.drain();
+  simulation.deinit();
+
+  const auto middle = config.frameCount / 2;
+
+  for ( std::size_t stage {}; stage < StageCount; ++stage )
+  {
+    const auto begin =
+      frameTimes.data() + stage * config.frameCount;
+
+    std::nth_element(
+      begin, begin + middle, begin + config.frameCount );
+
+    auto& stageSamples = samples[stage];
+    stageSamples.values[stageSamples.count++] = begin[middle];
+  }
+
+  return true;
+}
+
+//  Runs every repetition of the selected scenarios, or of all without
+//  a selection. Repetitions cycle through the scenarios, so slow
+//  drifts of the machine's speed spread over all of them
+bool
+runScenarios(
+  const BenchmarkConfig& config,
+  const bool* selected,
+  Array <double>& frameTimes,
+  Array <StageSamples>& samples )
+{
+  for ( std::size_t i {}; i < config.repetitionCount; ++i )
+  for ( std::size_t scenario {}; scenario < ScenarioCount; ++scenario )
+  {
+    if ( selected != nullptr && selected[scenario] == false )
+      continue;
+
+    SimulationConfig simulationConfig {};
+    simulationConfig.boidCount = config.boidCount;
+    simulationConfig.frameCount = config.frameCount;
+    simulationConfig.seed = config.seed;
+
+    Scenarios[scenario].configure(simulationConfig);
+
+    if ( runRepetition(simulationConfig, config, frameTimes, samples.data() + scenario * StageCount) == false )
+    {
+      std::cout << scenarioName(scenario) << ": invalid config or out of memory\n";
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+//  Text, one line per scenario and stage with its repetition medians,
+//  so baselines of different runs can be diffed
+bool
+writeBaseline(
+  const char* path,
+  const BenchmarkConfig& config,
+  const CpuIsa isa,
+  const char* host,
+  const Array <StageSamples>& samples )
+{
+  const auto file = std::fopen(path, "w");
+
+  if ( file == nullptr )
+    return false;
+
+  std::fprintf(
+    file, "%s %d %zu %zu %s %s\n",
+    BaselineMagic, BaselineVersion,
+    config.boidCount, config.frameCount, cpuIsaName(isa), host );
+
+  for ( std::size_t scenario {}; scenario < ScenarioCount; ++scenario )
+  for ( std::size_t stage {}; stage < StageCount; ++stage )
+  {
+    const auto& stageSamples = samples[scenario * StageCount + stage];
+
+    std::fprintf(
+      file, "%s %s %zu",
+      scenarioName(scenario), StageNames[stage], stageSamples.count );
+
+    for ( std::size_t i {}; i < stageSamples.count; ++i )
+      std::fprintf(file, " %.3f", stageSamples.values[i]);
+
+    std::fprintf(file, "\n");
+  }
+
+  return std::fclose(file) == 0;
+}
+
+//  Lines of scenarios or stages this build doesn't know are skipped.
+//  False if the file is missing, malformed or measured another flock
+bool
+readBaseline(
+  const char* path,
+  const BenchmarkConfig& config,
+  Array <StageSamples>& samples,
+  char (&isaName) [32],
+  char (&host) [HostNameLength] )
+{
+  const auto file = std::fopen(path, "r");
+
+  if ( file == nullptr )
+    return false;
+
+  char magic [32] {};
+  int version {};
+  std::size_t boidCount {};
+  std::size_t frameCount {};
+
+  bool valid =
+    std::fscanf(file, "%31s %d %zu %zu %31s %63s",
+      magic, &version, &boidCount, &frameCount, isaName, host) == 6 &&
+    std::strcmp(magic, BaselineMagic) == 0 &&
+    version == BaselineVersion;
+
+  if ( valid == true &&
+       (boidCount != config.boidCount || frameCount != config.frameCount) )
+  {
+    std::cout <<
+      path << " measured " << boidCount << " boids over " <<
+      frameCount << " frames\n";
+
+    valid = false;
+  }
+
+  char scenario [64] {};
+  char stage [64] {};
+  std::size_t count {};
+
+  while ( valid == true &&
+          std::fscanf(file, "%63s %63s %zu", scenario, stage, &count) == 3 )
+  {
+    if ( count > MaxBenchmarkRepetitions )
+    {
+      valid = false;
+      break;
+    }
+
+    StageSamples stageSamples {};
+    stageSamples.count = count;
+
+    for ( std::size_t i {}; i < count && valid == true; ++i )
+      valid = std::fscanf(file, "%lf", &stageSamples.values[i]) == 1;
+
+    const auto scenarioIndex = findScenario(scenario);
+    const auto stageIndex = findStage(stage);
+
+    if ( scenarioIndex < ScenarioCount && stageIndex < StageCount )
+      samples[scenarioIndex * StageCount + stageIndex] = stageSamples;
+  }
+
+  valid = valid == true && std::feof(file) != 0;
+
+  std::fclose(file);
+
+  return valid;
+}
+
+
+//  a stage's comparison against the baseline
+struct StageComparison
+{
+  double change {};
+  double p {1.0};
+
+//  only stages with a baseline of at least minStageTime are tested
+  bool tested {};
+  bool regressed {};
+};
+
+
+//  Marks the stages that regressed among the candidates, or all stages
+//  without candidates, returns their count. The p-values are corrected
+//  over every tested stage with Holm's method, so the chance of any
+//  stage failing a run by noise alone stays below significance
+std::size_t
+findRegressions(
+  const BenchmarkConfig& config,
+  const Array <StageSamples>& baseline,
+  const Array <StageSamples>& samples,
+  const Array <bool>* candidates,
+  Array <StageComparison>& comparisons,
+  Array <std::size_t>& order )
+{
+  std::size_t testedCount {};
+
+  for ( std::size_t i {}; i < comparisons.length(); ++i )
+  {
+    auto& comparison = comparisons[i];
+    comparison = {};
+
+    const auto previous = baseline[i].median();
+
+    if ( (candidates != nullptr && (*candidates)[i] == false) ||
+         baseline[i].count == 0 || samples[i].count == 0 ||
+         previous <= 0.0 || previous < config.minStageTime )
+      continue;
+
+    comparison.change = samples[i].median() / previous - 1.0;
+    comparison.p = mannWhitneyGreaterP(baseline[i], samples[i]);
+    comparison.tested = true;
+
+    order[testedCount++] = i;
+  }
+
+  std::sort(
+    order.data(), order.data() + testedCount,
+    [&comparisons] ( const std::size_t lhs, const std::size_t rhs )
+    {
+      return comparisons[lhs].p < comparisons[rhs].p;
+    });
+
+  std::size_t regressionCount {};
+
+//  the k-th smallest p-value is held to significance / (m - k),
+//  stopping at the first one that misses it
+  for ( std::size_t k {}; k < testedCount; ++k )
+  {
+    auto& comparison = comparisons[order[k]];
+
+    if ( comparison.p >= config.significance / (testedCount - k) )
+      break;
+
+    if ( comparison.change > config.maxSlowdown )
+    {
+      comparison.regressed = true;
+      ++regressionCount;
+    }
+  }
+
+  return regressionCount;
+}
+
+//  prints the stages a scenario ran, or only its candidates
+void
+printScenario(
+  const std::size_t scenario,
+  const StageSamples* baseline,
+  const StageSamples* samples,
+  const StageComparison* comparisons,
+  const bool* candidates )
+{
+  for ( std::size_t stage {}; stage < StageCount; ++stage )
+  {
+    const auto current = samples[stage].median();
+    const auto previous = baseline[stage].median();
+
+//    stages the scenario doesn't run
+    if ( current == 0.0 && previous == 0.0 )
+      continue;
+
+    if ( candidates != nullptr && candidates[stage] == false )
+      continue;
+
+    std::printf(
+      "%-12s %-22s", scenarioName(scenario), StageNames[stage] );
+
+    if ( baseline[stage].count == 0 )
+    {
+      std::printf(
+        " %12s %12.1f %9s %8s  new\n",
+        "-", current, "-", "-" );
+
+      continue;
+    }
+
+    const auto& comparison = comparisons[stage];
+
+    const char* verdict = "ok";
+
+    if ( comparison.tested == false )
+      verdict = "small";
+
+    else if ( comparison.regressed == true )
+      verdict = "REGRESSED";
+
+    std::printf(
+      " %12.1f %12.1f %+8.1f%% %8.4f  %s\n",
+      previous, current, comparison.change * 100.0,
+      comparison.p, verdict );
+  }
+}
+
+void
+printHeader()
+{
+  std::printf(
+    "%-12s %-22s %12s %12s %9s %8s  %s\n",
+    "scenario", "stage", "baseline us", "current us",
+    "change", "p", "verdict" );
+}
+}
+
+
+double
+StageSamples::median() const
+{
+  if ( count == 0 )
+    return {};
+
+  double sorted [MaxBenchmarkRepetitions] {};
+  std::copy_n(values, count, sorted);
+  std::sort(sorted, sorted + count);
+
+  return count % 2 == 1
+    ? sorted[count / 2]
+    : (sorted[count / 2 - 1] + sorted[count / 2]) * 0.5;
+}
+
+double
+mannWhitneyGreaterP(
+  const StageSamples& baseline,
+  const StageSamples& samples )
+{
+  const auto n1 = static_cast <double> (baseline.count);
+  const auto n2 = static_cast <double> (samples.count);
+
+  if ( baseline.count == 0 || samples.count == 0 )
+    return 1.0;
+
+  struct Ranked
+  {
+    double value {};
+    bool isSample {};
+  };
+
+  Ranked pooled [MaxBenchmarkRepetitions * 2] {};
+  const auto pooledCount = baseline.count + samples.count;
+
+  for ( std::size_t i {}; i < baseline.count; ++i )
+    pooled[i] = {baseline.values[i], false};
+
+  for ( std::size_t i {}; i < samples.count; ++i )
+    pooled[baseline.count + i] = {samples.values[i], true};
+
+  std::sort(
+    pooled, pooled + pooledCount,
+    [] ( const Ranked& lhs, const Ranked& rhs )
+    {
+      return lhs.value < rhs.value;
+    });
+
+  double rankSum {};
+  double tieSum {};
+
+//  tied values share the mean of their ranks
+  for ( std::size_t begin {}; begin < pooledCount; )
+  {
+    auto end = begin + 1;
+
+    while ( end < pooledCount && pooled[end].value == pooled[begin].value )
+      ++end;
+
+    const double tieCount = end - begin;
+    const double rank = (begin + 1 + end) * 0.5;
+
+    for ( auto i = begin; i < end; ++i )
+      if ( pooled[i].isSample == true )
+        rankSum += rank;
+
+    tieSum += tieCount * tieCount * tieCount - tieCount;
+    begin = end;
+  }
+
+  const double n = pooledCount;
+
+  const auto u = rankSum - n2 * (n2 + 1.0) * 0.5;
+  const auto mean = n1 * n2 * 0.5;
+
+  const auto variance =
+    n1 * n2 / 12.0 * ((n + 1.0) - tieSum / (n * (n - 1.0)));
+
+//  every value tied
+  if ( variance <= 0.0 )
+    return 1.0;
+
+//  continuity corrected
+  const auto z = (u - mean - 0.5) / std::sqrt(variance);
+
+  return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+
+int
+runBenchmarks(
+  const BenchmarkConfig& config )
+{
+  if ( config.repetitionCount == 0 ||
+       config.repetitionCount > MaxBenchmarkRepetitions ||
+       config.frameCount == 0 )
+  {
+    std::cout << "benchmarks need 1 to " << MaxBenchmarkRepetitions <<
+      " repetitions of at least 1 frame\n";
+
+    return 2;
+  }
+
+  const auto sampleCount = ScenarioCount * StageCount;
+
+  AllocatorArena allocator {};
+
+  if ( allocator.reserve(
+        sizeof(StageSamples) * sampleCount * 3 +
+        sizeof(StageComparison) * sampleCount +
+        sizeof(std::size_t) * sampleCount +
+        sizeof(bool) * sampleCount +
+        sizeof(double) * StageCount * config.frameCount +
+        sizeof(std::size_t) * 28 ) == false )
+  {
+    std::cout << "out of memory\n";
+    return 2;
+  }
+
+  int result {};
+
+  {
+    Array <StageSamples> baseline {allocator, sampleCount};
+    Array <StageSamples> samples {allocator, sampleCount};
+    Array <StageSamples> rerunSamples {allocator, sampleCount};
+    Array <StageComparison> comparisons {allocator, sampleCount};
+    Array <std::size_t> order {allocator, sampleCount};
+    Array <bool> candidates {allocator, sampleCount};
+    Array <double> frameTimes {allocator, StageCount * config.frameCount};
+
+    char host [HostNameLength] {};
+    hostName(host);
+
+    char defaultPath [HostNameLength + 32] {};
+
+    std::snprintf(
+      defaultPath, sizeof(defaultPath),
+      "perf_baseline-%s.txt", host );
+
+    const auto baselinePath =
+      config.baselinePath != nullptr
+        ? config.baselinePath
+        : defaultPath;
+
+//    scenarios run the best kernels the host allows
+    const auto isa = std::min(selectCpuIsa(), SimulationConfig{}.maxIsa);
+
+    char baselineIsa [32] {};
+    char baselineHost [HostNameLength] {};
+
+    const auto baselineFile = std::fopen(baselinePath, "r");
+    const bool baselineExists = baselineFile != nullptr;
+
+    if ( baselineFile != nullptr )
+      std::fclose(baselineFile);
+
+    bool hasBaseline = readBaseline(
+      baselinePath, config, baseline, baselineIsa, baselineHost );
+
+    if ( baselineExists == false )
+      std::cout << "no baseline of this host yet, recording " << baselinePath << "\n";
+
+    else if ( hasBaseline == false )
+      std::cout << "no usable baseline in " << baselinePath << "\n";
+
+//    timings of other machines or kernels can't tell a regression
+    else if ( std::strcmp(baselineHost, host) != 0 ||
+              std::strcmp(baselineIsa, cpuIsaName(isa)) != 0 )
+    {
+      std::cout <<
+        "the baseline ran " << baselineIsa << " kernels on " << baselineHost <<
+        ", this is " << cpuIsaName(isa) << " on " << host << "\n";
+
+      hasBaseline = false;
+    }
+
+//    a baseline of this host is only replaced on request
+    const auto writesBaseline =
+      config.updateBaseline == true || baselineExists == false;
+
+//    stages without baseline samples are shown as new
+    if ( hasBaseline == false )
+      for ( std::size_t i {}; i < sampleCount; ++i )
+        baseline[i] = {};
+
+    if ( hasBaseline == false && writesBaseline == false )
+    {
+      std::cout << "record a baseline of this host with updateBaseline\n";
+      result = 2;
+    }
+
+    if ( result == 0 &&
+         runScenarios(config, nullptr, frameTimes, samples) == false )
+      result = 2;
+
+    if ( result == 0 )
+    {
+      const auto regressionCount = hasBaseline == true
+        ? findRegressions(config, baseline, samples, nullptr, comparisons, order)
+        : 0;
+
+      printHeader();
+
+      for ( std::size_t scenario {}; scenario < ScenarioCount; ++scenario )
+        printScenario(
+          scenario,
+          baseline.data() + scenario * StageCount,
+          samples.data() + scenario * StageCount,
+          comparisons.data() + scenario * StageCount,
+          nullptr );
+
+      if ( regressionCount > 0 )
+      {
+        std::cout <<
+          regressionCount << " stages regressed, "
+          "rerunning their scenarios to confirm\n";
+
+        bool rerunScenarios [ScenarioCount] {};
+
+        for ( std::size_t i {}; i < sampleCount; ++i )
+        {
+          candidates[i] = comparisons[i].regressed;
+
+          if ( candidates[i] == true )
+            rerunScenarios[i / StageCount] = true;
+        }
+
+        if ( runScenarios(config, rerunScenarios, frameTimes, rerunSamples) == false )
+          result = 2;
+      }
+
+//      a stage only fails the run when it regresses in both runs
+      if ( result == 0 && regressionCount > 0 )
+      {
+        const auto confirmedCount = findRegressions(
+          config, baseline, rerunSamples, &candidates, comparisons, order );
+
+        printHeader();
+
+        for ( std::size_t scenario {}; scenario < ScenarioCount; ++scenario )
+          printScenario(
+            scenario,
+            baseline.data() + scenario * StageCount,
+            rerunSamples.data() + scenario * StageCount,
+            comparisons.data() + scenario * StageCount,
+            candidates.data() + scenario * StageCount );
+
+        std::cout << confirmedCount << " stages regressed again\n";
+
+        if ( confirmedCount > 0 )
+          result = 1;
+      }
+    }
+
+    if ( result != 2 && writesBaseline == true )
+    {
+      if ( writeBaseline(baselinePath, config, isa, host, samples) == true )
+        std::cout << "wrote baseline " << baselinePath << "\n";
+
+      else
+      {
+        std::cout << "can't write baseline " << baselinePath << "\n";
+        result = 2;
+      }
+    }
+  }
+
+  allocator.free();
+
+  return result;
+}
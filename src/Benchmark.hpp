@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Simulation.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+struct BenchmarkConfig
+{
+//  of every scenario, each repetition spawns a fresh flock
+//  and steps it warmupFrameCount frames before measuring
+  std::size_t boidCount {100'000};
+  std::size_t repetitionCount {15};
+  std::size_t warmupFrameCount {10};
+  std::size_t frameCount {60};
+
+  float delta {1.f / 240.f};
+  std::uint32_t seed {1};
+
+//  A stage regresses when its median over the repetitions grows by more
+//  than maxSlowdown and a one-sided Mann-Whitney U test, Holm-corrected
+//  over all tested stages, puts the chance of the growth being noise
+//  below significance. Regressed scenarios are rerun and only stages
+//  regressing again fail. Stages whose baseline median is under
+//  minStageTime microseconds are shown but never fail
+  double maxSlowdown {0.05};
+  double significance {0.01};
+  double minStageTime {50.0};
+
+//  baselines are timings of one machine, so they aren't committed.
+//  Null for perf_baseline-<host name>.txt in the working directory
+  const char* baselinePath {};
+
+//  overwrites the baseline with this run after comparing. A missing
+//  baseline is recorded by the run, one of another host or other
+//  kernels fails the run otherwise
+  bool updateBaseline {false};
+};
+
+//  per repetition medians of every stage
+constexpr std::size_t MaxBenchmarkRepetitions {32};
+
+struct StageSamples
+{
+  double values [MaxBenchmarkRepetitions] {};
+  std::size_t count {};
+
+  double median() const;
+};
+
+
+//  Probability of samples at least this much larger than the baseline's
+//  if both came from the same distribution: the one-sided p-value of the
+//  Mann-Whitney U test, normal approximation with a tie correction
+double mannWhitneyGreaterP(
+  const StageSamples& baseline,
+  const StageSamples& samples );
+
+
+//  Runs the fixed benchmark scenarios, prints a table of per-stage
+//  medians against the baseline and returns the process exit code:
+//  0 without regressions, 1 with confirmed ones, 2 if the run couldn't
+//  be completed or the baseline is of another host or other kernels
+int runBenchmarks( const BenchmarkConfig& );
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "Boids.hpp"
+#include "FastMath.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+//  How a single boid steers and moves, shared by the Simulation kernels
+//  and the ranks of a domain decomposition so both fly the same flock.
+//  Rules read the averages of the group a boid steers by and return
+//  the weighted steering they add to its heading, then the boid turns
+//  towards its desired velocity and moves
+
+
+//  A boid alone in its group averages to exactly itself, so its rules
+//  cancel out. Fast-math may divide by an approximate reciprocal, which
+//  would leave a rounding residue for the rules to normalize into a turn
+inline Vector3
+groupAverage(
+  const Vector3& sum,
+  const float count )
+{
+  return count > 1.f
+    ? sum / count
+    : sum;
+}
+
+
+template <NormalizeMode normalization>
+inline Vector3
+alignmentRule(
+  const BoidRuleset& ruleset,
+  const Vector3& velocity,
+  const Vector3& averageVelocity )
+{
+  return
+    ruleset.weights.alignment *
+    normalize <normalization> (averageVelocity - velocity);
+}
+
+//  Unit vector from a boid to its group's average position. Coherence
+//  steers along it and separation against it, sharing the one vector
+//  lets equal weights cancel exactly however fast-math reorders them
+template <NormalizeMode normalization>
+inline Vector3
+towardsCenter(
+  const Vector3& position,
+  const Vector3& averagePosition )
+{
+  return normalize <normalization> (averagePosition - position);
+}
+
+inline Vector3
+coherenceRule(
+  const BoidRuleset& ruleset,
+  const Vector3& towardsCenter )
+{
+  return ruleset.weights.coherence * towardsCenter;
+}
+
+inline Vector3
+separationRule(
+  const BoidRuleset& ruleset,
+  const Vector3& towardsCenter )
+{
+  return -ruleset.weights.separation * towardsCenter;
+}
+
+
+inline Vector3::value_type
+getAvoidance(
+  const Vector3::value_type coordinate,
+  const Vector3::value_type margin )
+{
+  if ( coordinate > 1 - margin )
+    return -1;
+
+  if ( coordinate < margin )
+    return 1;
+
+  return {};
+}
+
+template <BoundaryMode boundary>
+inline Vector3
+wallAvoidance(
+  const Vector3& position,
+  const Vector3::value_type margin )
+{
+  if constexpr ( boundary == BoundaryMode::Periodic )
+    return {};
+
+  else
+    return
+    {
+      getAvoidance(position.x, margin),
+      getAvoidance(position.y, margin),
+      getAvoidance(position.z, margin),
+    };
+}
+
+
+//  avoidance overrides the rules while there is any
+template <NormalizeMode normalization>
+inline Vector3
+desiredVelocity(
+  const Vector3& heading,
+  const Vector3& avoidance )
+{
+  return avoidance.length_squared() > 0.f
+    ? normalize <normalization> (avoidance)
+    : normalize <normalization> (heading);
+}
+
+//  turns a unit velocity towards the desired one
+template <NormalizeMode normalization>
+inline Vector3
+steerVelocity(
+  const Vector3& velocity,
+  const Vector3& desired,
+  const float delta )
+{
+  return normalize <normalization> (
+    velocity + (desired - velocity) * delta );
+}
+
+
+inline Vector3::value_type
+wrapCoordinate(
+  const Vector3::value_type coordinate )
+{
+  const auto wrapped =
+    coordinate - std::floor(coordinate);
+
+//  tiny negative coordinates round up to 1
+  return wrapped < 1.f ? wrapped : 0.f;
+}
+
+//  moves a boid along its velocity, wrapping it around periodic space
+//  or keeping it inside the walls avoidance can't always turn it from
+template <BoundaryMode boundary>
+inline Vector3
+movePosition(
+  const Vector3& position,
+  const Vector3& velocity,
+  const float maxSpeed,
+  const float delta )
+{
+  const auto moved =
+    position + velocity * maxSpeed * delta;
+
+  if constexpr ( boundary == BoundaryMode::Periodic )
+    return
+    {
+      wrapCoordinate(moved.x),
+      wrapCoordinate(moved.y),
+      wrapCoordinate(moved.z),
+    };
+
+  else
+  {
+    const auto maxCoordinate =
+      1.f - std::numeric_limits <float>::epsilon();
+
+    return
+    {
+      std::clamp(moved.x, 0.f, maxCoordinate),
+      std::clamp(moved.y, 0.f, maxCoordinate),
+      std::clamp(moved.z, 0.f, maxCoordinate),
+    };
+  }
+}
@@ -0,0 +1,118 @@
+#include "Boids.hpp"
+
+#include <cassert>
+
+
+SpeciesTable::SpeciesTable(
+  AllocatorArena& allocator,
+  const std::size_t speciesCount,
+  const std::size_t boidCount )
+  : rulesets{allocator, speciesCount}
+  , interactions{allocator, speciesCount * speciesCount}
+  , boidOffsets{allocator, speciesCount + 1}
+{
+  assert(speciesCount > 0);
+  assert(speciesCount <= SpeciesId(~SpeciesId{}));
+
+  for ( std::size_t i {}; i <= speciesCount; ++i )
+    boidOffsets[i] = boidCount * i / speciesCount;
+}
+
+std::size_t
+SpeciesTable::count() const
+{
+  return rulesets.length();
+}
+
+std::size_t
+SpeciesTable::boidsBegin(
+  const SpeciesId id ) const
+{
+  return boidOffsets[id];
+}
+
+std::size_t
+SpeciesTable::boidsEnd(
+  const SpeciesId id ) const
+{
+  return boidOffsets[id + 1];
+}
+
+float
+SpeciesTable::interaction(
+  const SpeciesId lhs,
+  const SpeciesId rhs ) const
+{
+  return interactions[lhs * count() + rhs];
+}
+
+bool
+SpeciesTable::hasInteractions() const
+{
+  for ( std::size_t lhs {}; lhs < count(); ++lhs )
+    for ( std::size_t rhs {}; rhs < count(); ++rhs )
+      if ( lhs != rhs && interaction(lhs, rhs) != 0.f )
+        return true;
+
+  return false;
+}
+
+std::size_t
+SpeciesTable::memoryRequirement(
+  const std::size_t speciesCount )
+{
+  return
+    sizeof(BoidRuleset) * speciesCount +
+    sizeof(float) * speciesCount * speciesCount +
+    sizeof(std::size_t) * (speciesCount + 1) +
+    sizeof(std::size_t) * 3;
+}
+
+
+GroupTable::GroupTable(
+  AllocatorArena& allocator,
+  const std::size_t capacity,
+  const bool hasStencil )
+  : aggregates{allocator, capacity}
+  , stencil{allocator, hasStencil ? capacity : 0}
+  , cell{allocator, capacity}
+  , species{allocator, capacity}
+{
+  assert(capacity < NoGroup);
+}
+
+std::size_t
+GroupTable::capacity() const
+{
+  return aggregates.length();
+}
+
+GroupId
+GroupTable::create(
+  const std::uint32_t cellId,
+  const SpeciesId speciesId,
+  const GroupId next )
+{
+  assert(count < capacity());
+
+  const auto groupId = static_cast <GroupId> (count++);
+
+  aggregates[groupId] = {{}, {}, 0, next};
+  cell[groupId] = cellId;
+  species[groupId] = speciesId;
+
+  return groupId;
+}
+
+std::size_t
+GroupTable::memoryRequirement(
+  const std::size_t capacity,
+  const bool hasStencil )
+{
+  return
+    (sizeof(GroupAggregate) * capacity + alignof(GroupAggregate)) *
+      (hasStencil ? 2 : 1) +
+    sizeof(std::uint32_t) * capacity +
+    sizeof(SpeciesId) * capacity +
+    sizeof(std::size_t) * 4;
+}
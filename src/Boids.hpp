@@ -0,0 +1,155 @@
+#pragma once
+
+#include "Containers.hpp"
+#include "Vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+struct BoidRuleset
+{
+  struct
+  {
+    float alignment {0.1f};
+    float coherence {0.1f};
+    float separation {0.1f};
+
+  } weights {};
+
+  float obstacleAvoidanceDistance {0.15f};
+  float maxSpeed {0.1f};
+};
+
+using SpeciesId = std::uint8_t;
+
+enum class BoundaryMode
+{
+  Bounded,  // unit cube walls, steered away from by obstacle avoidance
+  Periodic, // positions and neighbor lookups wrap around, no walls
+};
+
+enum class SpatialIndex
+{
+  Grid,   // uniform cells, boids group by cell
+  Octree, // Morton-ordered leaves sized to local density
+};
+
+//  Boids are stored sorted by species, so species s owns
+//  the contiguous index range [boidOffsets[s], boidOffsets[s + 1]).
+//  Kernels iterate species by species and keep the ruleset in locals.
+struct SpeciesTable
+{
+  Array <BoidRuleset> rulesets {};
+
+//  interactions[a * count() + b] is the attraction (> 0) or
+//  repulsion (< 0) a boid of species a feels towards the local
+//  centroid of species b. The diagonal is unused
+  Array <float> interactions {};
+
+  Array <std::size_t> boidOffsets {};
+
+
+  SpeciesTable() = default;
+
+  SpeciesTable(
+    AllocatorArena&,
+    const std::size_t speciesCount,
+    const std::size_t boidCount );
+
+
+  std::size_t count() const;
+
+  std::size_t boidsBegin( const SpeciesId ) const;
+  std::size_t boidsEnd( const SpeciesId ) const;
+
+  float interaction( const SpeciesId, const SpeciesId ) const;
+
+  bool hasInteractions() const;
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t speciesCount );
+};
+
+//  32-bit ids index the group tables, which are sized
+//  by how many groups can exist rather than by boids
+using GroupId = std::uint32_t;
+
+constexpr GroupId NoGroup {~GroupId{}};
+
+//  Sums over one group, the boids of one species in one grid cell or
+//  octree leaf. Packed into an aligned half cache line, so a rule
+//  fetches all it reads of a group at once
+struct alignas(32) GroupAggregate
+{
+  Vector3 position {};
+  Vector3 velocity {};
+  std::uint32_t count {};
+
+//  links groups sharing a cell, NoGroup terminates
+  GroupId next {NoGroup};
+};
+
+static_assert(sizeof(GroupAggregate) == 32);
+
+//  Groups are numbered densely in the order binning creates them,
+//  passes over groups only touch the first count entries
+struct GroupTable
+{
+  using AggregateArray = Array <GroupAggregate, alignof(GroupAggregate)>;
+
+
+  AggregateArray aggregates {};
+
+//  sums gathered over the neighbor cell stencil, empty without one
+  AggregateArray stencil {};
+
+//  cold, read by the stencil, species interactions and rebinning
+  Array <std::uint32_t> cell {};
+  Array <SpeciesId> species {};
+
+  std::size_t count {};
+
+
+  GroupTable() = default;
+
+  GroupTable(
+    AllocatorArena&,
+    const std::size_t capacity,
+    const bool hasStencil );
+
+
+  std::size_t capacity() const;
+
+  GroupId create(
+    const std::uint32_t cellId,
+    const SpeciesId,
+    const GroupId next );
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t capacity,
+    const bool hasStencil );
+};
+
+struct BoidData
+{
+  using FloatType = Vector3::value_type;
+
+
+  Array <Vector3> position {};
+  Array <Vector3> velocity {};
+
+  Array <std::uint32_t> cellId {};
+
+  Array <Vector3> obstacleAvoidance {};
+  Array <Vector3> alignment {};
+  Array <Vector3> coherence {};
+  Array <Vector3> separation {};
+
+//  the group whose aggregates the boid was summed into
+  Array <GroupId> groupId {};
+
+  Array <SpeciesId> species {};
+};
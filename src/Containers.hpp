@@ -2,6 +2,7 @@
 
 #include "Allocators.hpp"
 
+#include <atomic>
 #include <memory>
 #include <cassert>
 #include <cstddef>
@@ -88,7 +89,7 @@ Array <T, Alignment>::~Array() noexcept
 {
   std::destroy_n(mData, mLength);
 
-  if ( mAllocator != nullptr )
+  if ( mAllocator != nullptr && mData != nullptr )
     mAllocator->deallocate(mData, mLength);
 }
 
@@ -140,3 +141,355 @@ std::size_t Array <T, Alignment>::alignment() const noexcept
 }
 
 
+//  read-only window into contiguous elements owned elsewhere,
+//  only valid as long as the owner keeps them
+template <typename T>
+class ArrayView
+{
+  const T* mData {};
+  std::size_t mLength {};
+
+
+public:
+
+  ArrayView() = default;
+
+  ArrayView(
+    const T* data,
+    const std::size_t length ) noexcept;
+
+  template <std::size_t Alignment>
+  ArrayView( const Array <T, Alignment>& ) noexcept;
+
+
+  const T& operator [] ( const std::size_t index ) const noexcept;
+
+  const T* data() const noexcept;
+  std::size_t length() const noexcept;
+
+  const T* begin() const noexcept;
+  const T* end() const noexcept;
+};
+
+template <typename T>
+ArrayView <T>::ArrayView(
+  const T* data,
+  const std::size_t length ) noexcept
+  : mData{data}
+  , mLength{length}
+{
+}
+
+template <typename T>
+template <std::size_t Alignment>
+ArrayView <T>::ArrayView(
+  const Array <T, Alignment>& array ) noexcept
+  : mData{array.data()}
+  , mLength{array.length()}
+{
+}
+
+template <typename T>
+const T& ArrayView <T>::operator [] (
+  const std::size_t index ) const noexcept
+{
+  assert(index < mLength);
+
+  return mData[index];
+}
+
+template <typename T>
+const T* ArrayView <T>::data() const noexcept
+{
+  return mData;
+}
+
+template <typename T>
+std::size_t ArrayView <T>::length() const noexcept
+{
+  return mLength;
+}
+
+template <typename T>
+const T* ArrayView <T>::begin() const noexcept
+{
+  return mData;
+}
+
+template <typename T>
+const T* ArrayView <T>::end() const noexcept
+{
+  return mData + mLength;
+}
+
+
+constexpr std::size_t CacheLineSize {64};
+
+
+//  Bounded lock-free ring for one producing and one consuming thread.
+//  Each side owns its cursor on a cache line of its own and remembers
+//  the last value it read of the other's, so it only touches the
+//  other's line when the ring looks full or empty. The capacity must
+//  be a power of two
+template <typename T>
+class SpscQueue
+{
+  struct alignas(CacheLineSize) Cursor
+  {
+    std::atomic_size_t position {};
+
+//    the other side's position as last seen
+    std::size_t cached {};
+  };
+
+  Array <T, CacheLineSize> mSlots {};
+  std::size_t mMask {};
+
+  Cursor mHead {};
+  Cursor mTail {};
+
+
+public:
+
+  SpscQueue() = default;
+  SpscQueue( const SpscQueue& ) = delete;
+
+  SpscQueue( AllocatorArena&,
+    const std::size_t capacity ) noexcept;
+
+
+//  producer only, false if the ring is full
+  bool tryPush( const T& ) noexcept;
+
+//  consumer only, false if the ring is empty
+  bool tryPop( T& ) noexcept;
+
+  std::size_t capacity() const noexcept;
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t capacity ) noexcept;
+};
+
+template <typename T>
+SpscQueue <T>::SpscQueue(
+  AllocatorArena& allocator,
+  const std::size_t capacity ) noexcept
+  : mSlots{allocator, capacity}
+  , mMask{capacity - 1}
+{
+  assert(capacity > 0);
+  assert(IsPowerOfTwo(capacity));
+}
+
+template <typename T>
+bool SpscQueue <T>::tryPush(
+  const T& value ) noexcept
+{
+  assert(mSlots.length() > 0);
+
+  const auto tail = mTail.position.load(std::memory_order_relaxed);
+
+  if ( tail - mTail.cached == mSlots.length() )
+  {
+    mTail.cached = mHead.position.load(std::memory_order_acquire);
+
+    if ( tail - mTail.cached == mSlots.length() )
+      return false;
+  }
+
+  mSlots[tail & mMask] = value;
+  mTail.position.store(tail + 1, std::memory_order_release);
+
+  return true;
+}
+
+template <typename T>
+bool SpscQueue <T>::tryPop(
+  T& value ) noexcept
+{
+  assert(mSlots.length() > 0);
+
+  const auto head = mHead.position.load(std::memory_order_relaxed);
+
+  if ( head == mHead.cached )
+  {
+    mHead.cached = mTail.position.load(std::memory_order_acquire);
+
+    if ( head == mHead.cached )
+      return false;
+  }
+
+  value = mSlots[head & mMask];
+  mHead.position.store(head + 1, std::memory_order_release);
+
+  return true;
+}
+
+template <typename T>
+std::size_t SpscQueue <T>::capacity() const noexcept
+{
+  return mSlots.length();
+}
+
+template <typename T>
+std::size_t SpscQueue <T>::memoryRequirement(
+  const std::size_t capacity ) noexcept
+{
+  return
+    sizeof(T) * capacity +
+    CacheLineSize +
+    sizeof(std::size_t);
+}
+
+
+//  Bounded lock-free ring any number of threads may push to and pop
+//  from. Every slot carries a sequence number telling which lap of the
+//  ring it is ready for, so a thread claims a slot with one CAS on its
+//  cursor and hands it over with one release store, without locks or
+//  ABA. Cursors sit on separate cache lines, the capacity must be a
+//  power of two. Items one thread pushed are popped in order
+template <typename T>
+class MpmcQueue
+{
+  struct Slot
+  {
+    std::atomic_size_t sequence {};
+    T value {};
+  };
+
+  Array <Slot, CacheLineSize> mSlots {};
+  std::size_t mMask {};
+
+  alignas(CacheLineSize) std::atomic_size_t mPushPosition {};
+  alignas(CacheLineSize) std::atomic_size_t mPopPosition {};
+
+
+public:
+
+  MpmcQueue() = default;
+  MpmcQueue( const MpmcQueue& ) = delete;
+
+  MpmcQueue( AllocatorArena&,
+    const std::size_t capacity ) noexcept;
+
+
+//  false if the ring is full
+  bool tryPush( const T& ) noexcept;
+
+//  false if the ring is empty
+  bool tryPop( T& ) noexcept;
+
+  std::size_t capacity() const noexcept;
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t capacity ) noexcept;
+};
+
+template <typename T>
+MpmcQueue <T>::MpmcQueue(
+  AllocatorArena& allocator,
+  const std::size_t capacity ) noexcept
+  : mSlots{allocator, capacity}
+  , mMask{capacity - 1}
+{
+  assert(capacity > 0);
+  assert(IsPowerOfTwo(capacity));
+
+  for ( std::size_t i {}; i < capacity; ++i )
+    mSlots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+template <typename T>
+bool MpmcQueue <T>::tryPush(
+  const T& value ) noexcept
+{
+  assert(mSlots.length() > 0);
+
+  auto position = mPushPosition.load(std::memory_order_relaxed);
+
+  for ( ;; )
+  {
+    auto& slot = mSlots[position & mMask];
+
+    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+    const auto lap =
+      static_cast <std::ptrdiff_t> (sequence - position);
+
+//    the slot still holds an item of the previous lap
+    if ( lap < 0 )
+      return false;
+
+    if ( lap > 0 )
+    {
+      position = mPushPosition.load(std::memory_order_relaxed);
+      continue;
+    }
+
+    if ( mPushPosition.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed) == true )
+    {
+      slot.value = value;
+      slot.sequence.store(position + 1, std::memory_order_release);
+
+      return true;
+    }
+  }
+}
+
+template <typename T>
+bool MpmcQueue <T>::tryPop(
+  T& value ) noexcept
+{
+  assert(mSlots.length() > 0);
+
+  auto position = mPopPosition.load(std::memory_order_relaxed);
+
+  for ( ;; )
+  {
+    auto& slot = mSlots[position & mMask];
+
+    const auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+    const auto lap =
+      static_cast <std::ptrdiff_t> (sequence - (position + 1));
+
+//    nothing was pushed into the slot on this lap yet
+    if ( lap < 0 )
+      return false;
+
+    if ( lap > 0 )
+    {
+      position = mPopPosition.load(std::memory_order_relaxed);
+      continue;
+    }
+
+    if ( mPopPosition.compare_exchange_weak(
+          position, position + 1, std::memory_order_relaxed) == true )
+    {
+      value = slot.value;
+      slot.sequence.store(
+        position + mSlots.length(), std::memory_order_release );
+
+      return true;
+    }
+  }
+}
+
+template <typename T>
+std::size_t MpmcQueue <T>::capacity() const noexcept
+{
+  return mSlots.length();
+}
+
+template <typename T>
+std::size_t MpmcQueue <T>::memoryRequirement(
+  const std::size_t capacity ) noexcept
+{
+  return
+    sizeof(Slot) * capacity +
+    CacheLineSize +
+    sizeof(std::size_t);
+}
@@ -0,0 +1,151 @@
+#include "CpuFeatures.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <iostream>
+
+#if defined(KERNEL_MULTIVERSIONING)
+#include <cpuid.h>
+#endif
+
+
+const char*
+cpuIsaName(
+  const CpuIsa isa )
+{
+  return CpuIsaNames[static_cast <std::size_t> (isa)];
+}
+
+bool
+parseCpuIsa(
+  const char* name,
+  CpuIsa& isa )
+{
+  for ( std::size_t i {}; i < std::size(CpuIsaNames); ++i )
+  {
+    if ( std::strcmp(name, CpuIsaNames[i]) != 0 )
+      continue;
+
+    isa = static_cast <CpuIsa> (i);
+    return true;
+  }
+
+  return false;
+}
+
+#if defined(KERNEL_MULTIVERSIONING)
+
+namespace
+{
+//  XCR0, the register state the OS saves
+std::uint64_t
+readXcr0()
+{
+  std::uint32_t eax {};
+  std::uint32_t edx {};
+
+  __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+
+  return static_cast <std::uint64_t> (edx) << 32 | eax;
+}
+}
+
+CpuIsa
+detectCpuIsa()
+{
+  unsigned eax {}, ebx {}, ecx {}, edx {};
+
+  if ( __get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0 )
+    return CpuIsa::Baseline;
+
+//  the sse4.2 kernels are built with popcnt too
+  const bool hasSse42 =
+    (ecx & bit_SSE4_2) != 0 &&
+    (ecx & bit_POPCNT) != 0;
+
+  const bool hasFma = (ecx & bit_FMA) != 0;
+  const bool hasOsxsave = (ecx & bit_OSXSAVE) != 0;
+
+  if ( hasSse42 == false )
+    return CpuIsa::Baseline;
+
+//  xmm and ymm state
+  const std::uint64_t avxState {0x6};
+
+//  plus opmask and both halves of zmm0-31
+  const std::uint64_t avx512State {0xe6};
+
+  const auto xcr0 = hasOsxsave
+    ? readXcr0()
+    : 0;
+
+  if ( hasFma == false ||
+       (xcr0 & avxState) != avxState ||
+       __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0 )
+    return CpuIsa::Sse42;
+
+  const bool hasAvx2 =
+    (ebx & bit_AVX2) != 0 &&
+    (ebx & bit_BMI2) != 0;
+
+  if ( hasAvx2 == false )
+    return CpuIsa::Sse42;
+
+  const bool hasAvx512 =
+    (ebx & bit_AVX512F) != 0 &&
+    (ebx & bit_AVX512VL) != 0 &&
+    (ebx & bit_AVX512DQ) != 0 &&
+    (ebx & bit_AVX512BW) != 0 &&
+    (xcr0 & avx512State) == avx512State;
+
+  return hasAvx512
+    ? CpuIsa::Avx512
+    : CpuIsa::Avx2;
+}
+
+#else
+
+CpuIsa
+detectCpuIsa()
+{
+  return CpuIsa::Baseline;
+}
+
+#endif
+
+CpuIsa
+selectCpuIsa()
+{
+  static const CpuIsa selected = []
+  {
+    const auto detected = detectCpuIsa();
+
+    const auto override = std::getenv("BOIDS_ISA");
+
+    if ( override == nullptr )
+      return detected;
+
+    CpuIsa requested {};
+
+    if ( parseCpuIsa(override, requested) == false )
+    {
+      std::cout << "unknown BOIDS_ISA " << override <<
+        ", using " << cpuIsaName(detected) << "\n";
+
+      return detected;
+    }
+
+    if ( requested > detected )
+    {
+      std::cout << "BOIDS_ISA " << override <<
+        " isn't supported here, using " << cpuIsaName(detected) << "\n";
+
+      return detected;
+    }
+
+    return requested;
+  }();
+
+  return selected;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+//  Kernels are compiled once per instruction set with GCC's target
+//  pragma and the variant the CPU supports is picked at runtime.
+//  Other compilers and architectures only build the baseline
+#if defined(__GNUC__) && !defined(__clang__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define KERNEL_MULTIVERSIONING
+#endif
+
+
+//  ordered, every level implies the ones below it
+enum class CpuIsa : std::uint8_t
+{
+  Baseline, // whatever the build targets, SSE2 on x86-64
+  Sse42,
+  Avx2,     // with FMA and BMI2
+  Avx512,   // F, VL, DQ and BW
+};
+
+#if defined(KERNEL_MULTIVERSIONING)
+constexpr std::size_t CpuIsaCount {4};
+#else
+constexpr std::size_t CpuIsaCount {1};
+#endif
+
+//  names BOIDS_ISA accepts
+constexpr const char* CpuIsaNames [] {
+  "baseline", "sse4.2", "avx2", "avx512" };
+
+
+const char* cpuIsaName( const CpuIsa );
+
+//  false for names not in CpuIsaNames
+bool parseCpuIsa(
+  const char* name,
+  CpuIsa& );
+
+//  highest level both the CPU and the OS support, the latter
+//  has to save the wider registers on context switches
+CpuIsa detectCpuIsa();
+
+//  Detects the level once per process. The BOIDS_ISA environment
+//  variable can lower it, a level the host lacks is never selected
+CpuIsa selectCpuIsa();
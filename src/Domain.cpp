@@ -0,0 +1,781 @@
+#include "Domain.hpp"
+#include "BoidRules.hpp"
+
+#if !defined(_WIN32)
+#include "ShmTransport.hpp"
+
+#include <csignal>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+
+
+namespace
+{
+
+std::size_t
+toCell(
+  const float coordinate,
+  const std::size_t cellCount )
+{
+  return std::min(
+    static_cast <std::size_t> (std::max(coordinate, 0.f) * cellCount),
+    cellCount - 1 );
+}
+
+std::size_t
+ownedCapacityOf(
+  const DomainConfig& config,
+  const std::size_t rankCount )
+{
+  return
+    config.capacityFactor *
+    ((config.boidCount + rankCount - 1) / rankCount);
+}
+
+std::size_t
+messageBoidsOf(
+  const std::size_t messageCapacity )
+{
+  return messageCapacity / sizeof(DomainBoid);
+}
+
+std::size_t
+localCellCountOf(
+  const DomainConfig& config,
+  const std::size_t rank,
+  const std::size_t rankCount )
+{
+  const auto cellsPerAxis = config.cellsPerAxis;
+
+  const auto slabWidth =
+    cellsPerAxis * (rank + 1) / rankCount -
+    cellsPerAxis * rank / rankCount;
+
+  return
+    (slabWidth + 2 * config.haloRadius) *
+    cellsPerAxis * cellsPerAxis;
+}
+
+//  halos come from two neighbors, migrants mostly go to them
+constexpr std::size_t NeighborCount {2};
+
+constexpr std::size_t MaxRankCount {256};
+
+struct RankReport
+{
+  std::size_t ownedCount {};
+  std::size_t overflowCount {};
+  std::size_t deferredCount {};
+
+  Vector3 positionSum {};
+  Vector3 velocitySum {};
+
+  double frameTimeUs {};
+};
+
+} // namespace
+
+
+DomainRank::DomainRank(
+  AllocatorArena& allocator,
+  const DomainConfig& domainConfig,
+  const std::size_t rankId,
+  const std::size_t ranks,
+  const std::size_t messageCapacity )
+  : config{domainConfig}
+  , rank{rankId}
+  , rankCount{ranks}
+  , cellBegin{domainConfig.cellsPerAxis * rankId / ranks}
+  , cellEnd{domainConfig.cellsPerAxis * (rankId + 1) / ranks}
+  , position{allocator,
+      ownedCapacityOf(domainConfig, ranks) +
+      messageBoidsOf(messageCapacity) * NeighborCount}
+  , velocity{allocator, position.length()}
+  , cellId{allocator, position.length()}
+  , ownedCapacity{ownedCapacityOf(domainConfig, ranks)}
+  , cellPosition{allocator, localCellCountOf(domainConfig, rankId, ranks)}
+  , cellVelocity{allocator, cellPosition.length()}
+  , cellCount{allocator, cellPosition.length()}
+  , stencilPosition{allocator,
+      domainConfig.haloRadius > 0 ? cellPosition.length() : 0}
+  , stencilVelocity{allocator, stencilPosition.length()}
+  , stencilCount{allocator, stencilPosition.length()}
+  , outbox{allocator, messageBoidsOf(messageCapacity)}
+  , migrants{allocator, messageBoidsOf(messageCapacity) * NeighborCount}
+  , migrantRank{allocator, migrants.length()}
+{
+  assert(rankCount > 0);
+  assert(cellEnd > cellBegin);
+
+//  halos only come from direct neighbors
+  assert(config.haloRadius <= cellEnd - cellBegin);
+}
+
+void
+DomainRank::spawn()
+{
+  ownedCount =
+    config.boidCount * (rank + 1) / rankCount -
+    config.boidCount * rank / rankCount;
+
+  assert(ownedCount <= ownedCapacity);
+
+  std::minstd_rand0 engine {static_cast <std::minstd_rand0::result_type> (rank + 1)};
+  std::uniform_real_distribution dist(0.f, 1.f);
+
+  const auto cellSize = 1.f / config.cellsPerAxis;
+
+  for ( std::size_t i {}; i < ownedCount; ++i )
+  {
+    position[i] =
+    {
+      (cellBegin + dist(engine) * (cellEnd - cellBegin)) * cellSize,
+      dist(engine),
+      dist(engine),
+    };
+
+    velocity[i] = Vector3
+    {
+      dist(engine) - 0.5f,
+      dist(engine) - 0.5f,
+      dist(engine) - 0.5f,
+    }.normalized();
+  }
+}
+
+void
+DomainRank::exchangeHalo(
+  Transport& transport )
+{
+  ghostCount = {};
+
+  const auto radius = config.haloRadius;
+
+  if ( radius == 0 )
+    return;
+
+  const bool hasLeft = rank > 0;
+  const bool hasRight = rank + 1 < rankCount;
+
+  const auto sendLayers =
+  [this, &transport, radius] ( const std::size_t peer, const bool left )
+  {
+    std::size_t count {};
+
+    for ( std::size_t i {}; i < ownedCount; ++i )
+    {
+      const auto cellX = toCell(position[i].x, config.cellsPerAxis);
+
+      const bool inLayers = left
+        ? cellX < cellBegin + radius
+        : cellX + radius >= cellEnd;
+
+      if ( inLayers == false )
+        continue;
+
+      if ( count == outbox.length() )
+      {
+        ++overflowCount;
+        continue;
+      }
+
+      outbox[count++] = {position[i], velocity[i]};
+    }
+
+    transport.send(
+      peer, outbox.data(), count * sizeof(DomainBoid) );
+  };
+
+  if ( hasLeft == true )
+    sendLayers(rank - 1, true);
+
+  if ( hasRight == true )
+    sendLayers(rank + 1, false);
+
+  transport.barrier();
+
+  const auto receiveGhosts =
+  [this, &transport] ( const std::size_t peer )
+  {
+    std::size_t bytes {};
+
+    const auto ghosts = static_cast <const DomainBoid*> (
+      transport.receive(peer, bytes) );
+
+    for ( std::size_t i {}; i < bytes / sizeof(DomainBoid); ++i )
+    {
+      const auto slot = ownedCount + ghostCount;
+
+      if ( slot == position.length() )
+      {
+        ++overflowCount;
+        continue;
+      }
+
+      position[slot] = ghosts[i].position;
+      velocity[slot] = ghosts[i].velocity;
+      ++ghostCount;
+    }
+  };
+
+  if ( hasLeft == true )
+    receiveGhosts(rank - 1);
+
+  if ( hasRight == true )
+    receiveGhosts(rank + 1);
+}
+
+void
+DomainRank::bin()
+{
+  std::fill_n(cellPosition.data(), cellPosition.length(), Vector3{});
+  std::fill_n(cellVelocity.data(), cellVelocity.length(), Vector3{});
+  std::fill_n(cellCount.data(), cellCount.length(), 0);
+
+  for ( std::size_t i {}; i < ownedCount + ghostCount; ++i )
+  {
+    const auto cell = localCell(position[i]);
+
+    cellId[i] = cell;
+    cellPosition[cell] += position[i];
+    cellVelocity[cell] += velocity[i];
+    ++cellCount[cell];
+  }
+
+  const auto radius =
+    static_cast <std::ptrdiff_t> (config.haloRadius);
+
+  if ( radius == 0 )
+    return;
+
+  const auto axisX =
+    static_cast <std::ptrdiff_t> (localCellsPerAxisX());
+
+  const auto axis =
+    static_cast <std::ptrdiff_t> (config.cellsPerAxis);
+
+//  only owned cells steer boids, halo cells just contribute
+  for ( auto z = std::ptrdiff_t{}; z < axis; ++z )
+  for ( auto y = std::ptrdiff_t{}; y < axis; ++y )
+  for ( auto x = radius; x < axisX - radius; ++x )
+  {
+    const auto cell = x + (y + z * axis) * axisX;
+
+    if ( cellCount[cell] == 0 )
+      continue;
+
+    Vector3 positionSum {};
+    Vector3 velocitySum {};
+    std::size_t count {};
+
+    for ( auto nz = std::max(z - radius, std::ptrdiff_t{}); nz <= std::min(z + radius, axis - 1); ++nz )
+    for ( auto ny = std::max(y - radius, std::ptrdiff_t{}); ny <= std::min(y + radius, axis - 1); ++ny )
+    for ( auto nx = x - radius; nx <= x + radius; ++nx )
+    {
+      const auto neighbor = nx + (ny + nz * axis) * axisX;
+
+      positionSum += cellPosition[neighbor];
+      velocitySum += cellVelocity[neighbor];
+      count += cellCount[neighbor];
+    }
+
+    stencilPosition[cell] = positionSum;
+    stencilVelocity[cell] = velocitySum;
+    stencilCount[cell] = count;
+  }
+}
+
+//  ranks fly the rules of a Simulation with the default config
+void
+DomainRank::steer()
+{
+  constexpr auto normalization = DefaultNormalizeMode;
+  constexpr auto boundary = BoundaryMode::Bounded;
+
+  const auto& ruleset = config.ruleset;
+  const auto delta = config.delta;
+
+  const bool hasHalo = config.haloRadius > 0;
+
+  for ( std::size_t i {}; i < ownedCount; ++i )
+  {
+    const auto cell = cellId[i];
+
+    auto& boidPosition = position[i];
+    auto& boidVelocity = velocity[i];
+
+//    boids still waiting to migrate sit in halo cells, which have no
+//    stencil, so they steer by their own cell as it holds at least them
+    const bool hasStencil =
+      hasHalo == true && stencilCount[cell] > 0;
+
+    const auto count = static_cast <float> (
+      hasStencil ? stencilCount[cell] : cellCount[cell] );
+
+    const auto averagePosition = groupAverage(
+      hasStencil ? stencilPosition[cell] : cellPosition[cell], count );
+
+    const auto averageVelocity = groupAverage(
+      hasStencil ? stencilVelocity[cell] : cellVelocity[cell], count );
+
+    const auto center = towardsCenter <normalization> (
+      boidPosition, averagePosition );
+
+    const auto heading =
+      alignmentRule <normalization> (ruleset, boidVelocity, averageVelocity) +
+      coherenceRule(ruleset, center) +
+      separationRule(ruleset, center);
+
+    const auto avoidance = wallAvoidance <boundary> (
+      boidPosition, ruleset.obstacleAvoidanceDistance );
+
+    boidVelocity = steerVelocity <normalization> (
+      boidVelocity,
+      desiredVelocity <normalization> (heading, avoidance),
+      delta );
+
+    boidPosition = movePosition <boundary> (
+      boidPosition, boidVelocity, ruleset.maxSpeed, delta );
+  }
+}
+
+void
+DomainRank::migrate(
+  Transport& transport )
+{
+  migrantCount = {};
+
+  const auto previousOwnedCount = ownedCount;
+
+  std::size_t keptCount {};
+
+  for ( std::size_t i {}; i < ownedCount; ++i )
+  {
+    const auto owner = ownerRank(position[i]);
+
+    if ( owner != rank && migrantCount < migrants.length() )
+    {
+      migrants[migrantCount] = {position[i], velocity[i]};
+      migrantRank[migrantCount] = owner;
+      ++migrantCount;
+      continue;
+    }
+
+    if ( owner != rank )
+      ++deferredCount;
+
+    position[keptCount] = position[i];
+    velocity[keptCount] = velocity[i];
+    ++keptCount;
+  }
+
+  ownedCount = keptCount;
+
+//  Every peer may send an even share of the room left after all of this
+//  rank's own boids, including the leaving ones which may have to stay,
+//  so arrivals always fit and no boid is lost
+  const auto roomCount = ownedCapacity - previousOwnedCount;
+
+  const std::size_t offeredCount =
+    rankCount > 1 ? roomCount / (rankCount - 1) : 0;
+
+  for ( std::size_t peer {}; peer < rankCount; ++peer )
+    if ( peer != rank )
+      transport.send(peer, &offeredCount, sizeof(offeredCount));
+
+  transport.barrier();
+
+  std::size_t acceptedCount [MaxRankCount] {};
+
+  for ( std::size_t peer {}; peer < rankCount; ++peer )
+  {
+    if ( peer == rank )
+      continue;
+
+    std::size_t bytes {};
+
+    const auto offer = static_cast <const std::size_t*> (
+      transport.receive(peer, bytes) );
+
+    assert(bytes == sizeof(std::size_t));
+
+    acceptedCount[peer] = std::min(*offer, outbox.length());
+  }
+
+  for ( std::size_t peer {}; peer < rankCount; ++peer )
+  {
+    if ( peer == rank )
+      continue;
+
+    std::size_t count {};
+
+    for ( std::size_t i {}; i < migrantCount; ++i )
+    {
+      if ( migrantRank[i] != peer )
+        continue;
+
+      if ( count < acceptedCount[peer] )
+      {
+        outbox[count++] = migrants[i];
+        continue;
+      }
+
+//      retried next frame
+      ++deferredCount;
+
+      position[ownedCount] = migrants[i].position;
+      velocity[ownedCount] = migrants[i].velocity;
+      ++ownedCount;
+    }
+
+    transport.send(
+      peer, outbox.data(), count * sizeof(DomainBoid) );
+  }
+
+  transport.barrier();
+
+  for ( std::size_t peer {}; peer < rankCount; ++peer )
+  {
+    if ( peer == rank )
+      continue;
+
+    std::size_t bytes {};
+
+    const auto arrivals = static_cast <const DomainBoid*> (
+      transport.receive(peer, bytes) );
+
+    for ( std::size_t i {}; i < bytes / sizeof(DomainBoid); ++i )
+    {
+      assert(ownedCount < ownedCapacity);
+
+      position[ownedCount] = arrivals[i].position;
+      velocity[ownedCount] = arrivals[i].velocity;
+      ++ownedCount;
+    }
+  }
+}
+
+void
+DomainRank::step(
+  Transport& transport )
+{
+  exchangeHalo(transport);
+  bin();
+  steer();
+  migrate(transport);
+}
+
+bool
+DomainRank::report(
+  Transport& transport,
+  const double frameTimeUs )
+{
+  RankReport report {};
+  report.ownedCount = ownedCount;
+  report.overflowCount = overflowCount;
+  report.deferredCount = deferredCount;
+  report.frameTimeUs = frameTimeUs;
+
+  for ( std::size_t i {}; i < ownedCount; ++i )
+  {
+    report.positionSum += position[i];
+    report.velocitySum += velocity[i];
+  }
+
+  transport.send(0, &report, sizeof(report));
+  transport.barrier();
+
+  if ( rank != 0 )
+    return true;
+
+  RankReport total {};
+
+  for ( std::size_t peer {}; peer < rankCount; ++peer )
+  {
+    std::size_t bytes {};
+
+    const auto& peerReport = *static_cast <const RankReport*> (
+      transport.receive(peer, bytes) );
+
+    assert(bytes == sizeof(RankReport));
+
+    total.ownedCount += peerReport.ownedCount;
+    total.overflowCount += peerReport.overflowCount;
+    total.deferredCount += peerReport.deferredCount;
+    total.positionSum += peerReport.positionSum;
+    total.velocitySum += peerReport.velocitySum;
+    total.frameTimeUs = std::max(total.frameTimeUs, peerReport.frameTimeUs);
+
+    std::cout <<
+      "rank " << peer <<
+      " boids " << peerReport.ownedCount <<
+      " frame " << peerReport.frameTimeUs << " us\n";
+  }
+
+  const auto pos = total.positionSum / total.ownedCount;
+  const auto vel = total.velocitySum / total.ownedCount;
+
+  std::cout << "domain ranks " << rankCount << ", boids " << total.ownedCount << " of " << config.boidCount << ", overflows " << total.overflowCount << ", deferred migrations " << total.deferredCount << "\n";
+  std::cout << "boid pos " << pos.x << ", " << pos.y << ", " << pos.z << "\n";
+  std::cout << "boid vel " << vel.x << ", " << vel.y << ", " << vel.z << "\n";
+  std::cout << "slowest rank frame took " << total.frameTimeUs << " us\n";
+
+  if ( total.ownedCount != config.boidCount )
+  {
+    std::cout << "boids were lost between ranks\n";
+    return false;
+  }
+
+  if ( total.overflowCount > 0 )
+  {
+    std::cout << "halos overflowed the transport, ghosts were dropped\n";
+    return false;
+  }
+
+  return true;
+}
+
+std::size_t
+DomainRank::localCellsPerAxisX() const
+{
+  return cellEnd - cellBegin + 2 * config.haloRadius;
+}
+
+std::size_t
+DomainRank::localCell(
+  const Vector3& boidPosition ) const
+{
+  const auto cellsPerAxis = config.cellsPerAxis;
+  const auto radius = config.haloRadius;
+
+//  boids outside slab and halo, waiting to migrate, use the edge cells
+  const auto x = std::clamp(
+    toCell(boidPosition.x, cellsPerAxis) + radius,
+    cellBegin,
+    cellEnd + 2 * radius - 1 ) - cellBegin;
+
+  const auto y = toCell(boidPosition.y, cellsPerAxis);
+  const auto z = toCell(boidPosition.z, cellsPerAxis);
+
+  return x + (y + z * cellsPerAxis) * localCellsPerAxisX();
+}
+
+std::size_t
+DomainRank::ownerRank(
+  const Vector3& boidPosition ) const
+{
+  const auto cellsPerAxis = config.cellsPerAxis;
+  const auto cellX = toCell(boidPosition.x, cellsPerAxis);
+
+  auto owner = std::min(cellX * rankCount / cellsPerAxis, rankCount - 1);
+
+  while ( cellX < cellsPerAxis * owner / rankCount )
+    --owner;
+
+  while ( cellX >= cellsPerAxis * (owner + 1) / rankCount )
+    ++owner;
+
+  return owner;
+}
+
+std::size_t
+DomainRank::messageCapacity(
+  const DomainConfig& config )
+{
+//  a halo holds haloRadius cell layers of an evenly spread flock,
+//  leave room for four times that much crowding
+  const auto layers = std::max(config.haloRadius, std::size_t{1});
+
+  const auto layerBoids =
+    config.boidCount * layers / config.cellsPerAxis;
+
+  return sizeof(DomainBoid) * (layerBoids * 4 + 1024);
+}
+
+std::size_t
+DomainRank::memoryRequirement(
+  const DomainConfig& config,
+  const std::size_t rankCount,
+  const std::size_t messageCapacity )
+{
+  const auto boidCapacity =
+    ownedCapacityOf(config, rankCount) +
+    messageBoidsOf(messageCapacity) * NeighborCount;
+
+  std::size_t maxCellCount {};
+
+  for ( std::size_t rank {}; rank < rankCount; ++rank )
+    maxCellCount = std::max(
+      maxCellCount, localCellCountOf(config, rank, rankCount) );
+
+  const auto cellMemory =
+    sizeof(Vector3) * 2 +
+    sizeof(std::size_t);
+
+  return
+    (sizeof(Vector3) * 2 + sizeof(std::size_t)) * boidCapacity +
+    cellMemory * maxCellCount * (config.haloRadius > 0 ? 2 : 1) +
+    sizeof(DomainBoid) * messageBoidsOf(messageCapacity) * (1 + NeighborCount) +
+    sizeof(std::size_t) * messageBoidsOf(messageCapacity) * NeighborCount +
+    sizeof(std::size_t) * 32;
+}
+
+#if !defined(_WIN32)
+
+namespace
+{
+
+int
+runRank(
+  const DomainConfig& config,
+  const char* segmentName,
+  const std::size_t rank,
+  const std::size_t rankCount )
+{
+  using Clock = std::chrono::steady_clock;
+
+  ShmTransport transport {};
+
+  if ( transport.open(segmentName, rank) == false )
+    return 1;
+
+  AllocatorArena allocator {};
+
+  if ( allocator.reserve(DomainRank::memoryRequirement(
+         config, rankCount, transport.messageCapacity() )) == false )
+    return 1;
+
+  bool succeeded {};
+
+  {
+    DomainRank domain {
+      allocator, config, rank, rankCount,
+      transport.messageCapacity() };
+
+    domain.spawn();
+
+    const auto begin = Clock::now();
+
+    for ( std::size_t frame {}; frame < config.frameCount; ++frame )
+      domain.step(transport);
+
+    const auto elapsedUs =
+      std::chrono::duration <double, std::micro> (Clock::now() - begin).count();
+
+    succeeded = domain.report(
+      transport, elapsedUs / std::max(config.frameCount, std::size_t{1}) );
+  }
+
+  allocator.free();
+
+  return succeeded == true ? 0 : 1;
+}
+
+} // namespace
+
+int
+runDomainProcesses(
+  const DomainConfig& config,
+  const std::size_t rankCount )
+{
+  assert(rankCount > 0);
+  assert(rankCount <= MaxRankCount);
+  assert(rankCount <= config.cellsPerAxis);
+
+  const auto segmentName =
+    "/boids-domain-" + std::to_string(getpid());
+
+  ShmTransport segment {};
+
+  if ( segment.create(
+         segmentName.c_str(), rankCount,
+         DomainRank::messageCapacity(config) ) == false )
+  {
+    std::cout << "failed to create shared memory segment " << segmentName << "\n";
+    return 1;
+  }
+
+//  children would flush the parent's buffered output again
+  std::cout.flush();
+
+  pid_t ranks [MaxRankCount] {};
+  std::size_t spawnedCount {};
+
+  for ( ; spawnedCount < rankCount; ++spawnedCount )
+  {
+    const auto pid = fork();
+
+    if ( pid == 0 )
+    {
+      const auto status = runRank(
+        config, segmentName.c_str(), spawnedCount, rankCount );
+
+      std::cout.flush();
+      _exit(status);
+    }
+
+    if ( pid < 0 )
+      break;
+
+    ranks[spawnedCount] = pid;
+  }
+
+  bool succeeded = spawnedCount == rankCount;
+
+//  the others would wait for a missing rank forever
+  const auto killRanks =
+  [&ranks, spawnedCount] ()
+  {
+    for ( std::size_t i {}; i < spawnedCount; ++i )
+      if ( ranks[i] > 0 )
+        kill(ranks[i], SIGKILL);
+  };
+
+  if ( succeeded == false )
+    killRanks();
+
+  for ( std::size_t exitedCount {}; exitedCount < spawnedCount; ++exitedCount )
+  {
+    int status {};
+    const auto pid = wait(&status);
+
+    if ( pid < 0 )
+      break;
+
+    std::replace(ranks, ranks + spawnedCount, pid, pid_t{});
+
+    if ( WIFEXITED(status) == true && WEXITSTATUS(status) == 0 )
+      continue;
+
+    if ( succeeded == true )
+      killRanks();
+
+    succeeded = false;
+  }
+
+  segment.close();
+  ShmTransport::unlink(segmentName.c_str());
+
+  return succeeded == true ? 0 : 1;
+}
+
+#else
+
+int
+runDomainProcesses(
+  const DomainConfig&,
+  const std::size_t )
+{
+  std::cout << "domain decomposition needs POSIX shared memory\n";
+  return 1;
+}
+
+#endif
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "Boids.hpp"
+#include "Transport.hpp"
+
+#include <cstddef>
+
+
+//  a boid as it travels between ranks
+struct DomainBoid
+{
+  Vector3 position {};
+  Vector3 velocity {};
+};
+
+struct DomainConfig
+{
+  std::size_t boidCount {};
+  std::size_t cellsPerAxis {};
+
+//  cell layers next to a slab its neighbors send as ghosts,
+//  also the stencil radius rules gather group sums from
+  std::size_t haloRadius {};
+
+  std::size_t frameCount {};
+  float delta {};
+
+  BoidRuleset ruleset {};
+
+//  owned boids a rank can hold relative to an even share,
+//  a rank only takes in migrants while it has room for them
+  std::size_t capacityFactor {2};
+};
+
+
+//  Simulates the slab of grid columns [cellBegin, cellEnd) along x owned
+//  by one rank of a bounded unit cube. Each frame the neighbor ranks send
+//  the boids of the haloRadius cell layers next to the slab as ghosts,
+//  owned boids and ghosts are binned into the rank's own grid, owned
+//  boids are steered and moved, and boids that left the slab migrate to
+//  the rank owning them now. A rank is single-threaded, processes are
+//  the unit of parallelism. Steering uses the rules of BoidRules.hpp,
+//  like the Simulation kernels.
+//  Halo ghosts that don't fit into the transport are dropped and counted
+//  in overflowCount, which fails the run. Migrants that don't fit into
+//  the transport or the receiver stay with their old rank until they do,
+//  counted in deferredCount, so boids are never lost
+struct DomainRank
+{
+  DomainConfig config {};
+
+  std::size_t rank {};
+  std::size_t rankCount {};
+
+  std::size_t cellBegin {};
+  std::size_t cellEnd {};
+
+//  owned boids first, ghosts after them
+  Array <Vector3> position {};
+  Array <Vector3> velocity {};
+  Array <std::size_t> cellId {};
+
+  std::size_t ownedCount {};
+  std::size_t ghostCount {};
+  std::size_t ownedCapacity {};
+
+//  slab cells plus halo layers on both sides, x varies fastest
+  Array <Vector3> cellPosition {};
+  Array <Vector3> cellVelocity {};
+  Array <std::size_t> cellCount {};
+
+//  halo gathered group sums, empty without a halo
+  Array <Vector3> stencilPosition {};
+  Array <Vector3> stencilVelocity {};
+  Array <std::size_t> stencilCount {};
+
+  Array <DomainBoid> outbox {};
+  Array <DomainBoid> migrants {};
+  Array <std::size_t> migrantRank {};
+  std::size_t migrantCount {};
+
+  std::size_t overflowCount {};
+  std::size_t deferredCount {};
+
+
+  DomainRank() = default;
+
+  DomainRank(
+    AllocatorArena&,
+    const DomainConfig&,
+    const std::size_t rank,
+    const std::size_t rankCount,
+    const std::size_t messageCapacity );
+
+
+  void spawn();
+
+  void exchangeHalo( Transport& );
+  void bin();
+  void steer();
+  void migrate( Transport& );
+
+  void step( Transport& );
+
+//  rank 0 prints the totals of all ranks, false
+//  there if boids were lost or ghosts dropped
+  bool report(
+    Transport&,
+    const double frameTimeUs );
+
+
+  std::size_t localCellsPerAxisX() const;
+
+  std::size_t localCell( const Vector3& ) const;
+
+  std::size_t ownerRank( const Vector3& ) const;
+
+
+  static std::size_t messageCapacity( const DomainConfig& );
+
+  static std::size_t memoryRequirement(
+    const DomainConfig&,
+    const std::size_t rankCount,
+    const std::size_t messageCapacity );
+};
+
+
+//  forks rankCount processes connected by a shared memory transport,
+//  each simulating one slab of the cube, returns the exit status,
+//  which fails on overflows and lost boids
+int runDomainProcesses(
+  const DomainConfig&,
+  const std::size_t rankCount );
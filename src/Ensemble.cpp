@@ -0,0 +1,285 @@
+#include "Ensemble.hpp"
+#include "ThreadPool.hpp"
+#include "PerformanceCounter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <iostream>
+
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+
+SimulationConfig
+memberConfigOf(
+  const EnsembleConfig& config,
+  const EnsembleMember& member )
+{
+  SimulationConfig memberConfig {};
+
+  memberConfig.boidCount = config.boidCount;
+  memberConfig.cellPerAxisCount = config.cellPerAxisCount;
+  memberConfig.frameCount = config.frameCount;
+  memberConfig.ruleset = member.ruleset;
+  memberConfig.seed = member.seed;
+
+//  a member steps on the thread running it
+  memberConfig.threadCount = 0;
+  memberConfig.pipelineDepth = 0;
+  memberConfig.publishFrames = false;
+
+  return memberConfig;
+}
+
+void
+simulateMember(
+  const EnsembleConfig& config,
+  const EnsembleMember& member,
+  AllocatorArena& slot,
+  EnsembleResult& result )
+{
+  const auto begin = Clock::now();
+
+  result = {};
+
+  Simulation simulation {};
+
+  if ( simulation.init(memberConfigOf(config, member), &slot) == false )
+    return;
+
+  simulation.stepN(config.frameCount, config.delta);
+
+  const auto positions = simulation.positions();
+  const auto velocities = simulation.velocities();
+
+  Vector3 centroid {};
+  Vector3 velocitySum {};
+  float speedSum {};
+
+  for ( std::size_t i {}; i < positions.length(); ++i )
+  {
+    centroid += positions[i];
+    velocitySum += velocities[i];
+    speedSum += velocities[i].length();
+  }
+
+  centroid /= positions.length();
+
+  float spreadSquared {};
+
+  for ( std::size_t i {}; i < positions.length(); ++i )
+    spreadSquared += (positions[i] - centroid).length_squared();
+
+  result.polarization = speedSum > 0.f
+    ? velocitySum.length() / speedSum
+    : 0.f;
+
+  result.spread = std::sqrt(spreadSquared / positions.length());
+
+  simulation.deinit();
+
+  result.time = double_us{Clock::now() - begin}.count();
+  result.completed = true;
+}
+}
+
+
+bool
+simulateEnsemble(
+  const EnsembleConfig& config,
+  const ArrayView <EnsembleMember>& members,
+  EnsembleResult* results )
+{
+  const auto slotCount = config.threadCount + 1;
+
+//  members only differ in rulesets and seeds, which don't change their
+//  memory, and reserving from a slot costs one more chunk header
+  const auto slotBytes =
+    Simulation::memoryRequirement(memberConfigOf(config, {})) +
+    sizeof(std::size_t);
+
+  AllocatorArena allocator {};
+
+  if ( allocator.reserve(
+        sizeof(AllocatorArena) * slotCount +
+        (slotBytes + sizeof(std::size_t)) * slotCount +
+        ThreadPool::memoryRequirement(config.threadCount) +
+        sizeof(std::size_t) * 2 ) == false )
+    return false;
+
+  std::size_t reservedCount {};
+
+  {
+    Array <AllocatorArena> slots {allocator, slotCount};
+
+    while ( reservedCount < slotCount &&
+            slots[reservedCount].reserve(slotBytes, &allocator) == true )
+      ++reservedCount;
+
+//    members only run once every thread has its slot
+    if ( reservedCount == slotCount )
+    {
+      ThreadPool threadPool {};
+      threadPool.init(allocator, config.threadCount);
+
+      std::atomic_size_t nextMember {};
+
+//      threads claim members one at a time, so
+//      members of uneven cost balance out
+      const auto runMembers =
+      [&config, &members, results, &slots, &nextMember] ( const std::size_t slot )
+      {
+        for ( ;; )
+        {
+          const auto memberId =
+            nextMember.fetch_add(1, std::memory_order_relaxed);
+
+          if ( memberId >= members.length() )
+            return;
+
+          simulateMember(
+            config, members[memberId], slots[slot], results[memberId] );
+        }
+      };
+
+      for ( std::size_t i {}; i < config.threadCount; ++i )
+        threadPool.push(
+        [&runMembers] ( const std::size_t threadId )
+        {
+          runMembers(threadId);
+        });
+
+      runMembers(config.threadCount);
+
+      threadPool.waitForTasks();
+      threadPool.deinit();
+    }
+
+    for ( auto i = reservedCount; i > 0; --i )
+      slots[i - 1].free(&allocator);
+  }
+
+  allocator.free();
+
+  return reservedCount == slotCount;
+}
+
+int
+runEnsemble(
+  const EnsembleConfig& config )
+{
+  if ( config.memberCount == 0 )
+  {
+    std::cout << "an ensemble needs members\n";
+    return 2;
+  }
+
+  AllocatorArena allocator {};
+
+  if ( allocator.reserve(
+        sizeof(EnsembleMember) * config.memberCount +
+        sizeof(EnsembleResult) * config.memberCount +
+        sizeof(std::size_t) * 4 ) == false )
+  {
+    std::cout << "out of memory\n";
+    return 2;
+  }
+
+  int result {};
+
+  {
+    Array <EnsembleMember> members {allocator, config.memberCount};
+    Array <EnsembleResult> results {allocator, config.memberCount};
+
+    std::minstd_rand0 engine {config.seed};
+    std::uniform_real_distribution weightDist(0.f, config.maxWeight);
+
+    for ( std::size_t i {}; i < members.length(); ++i )
+    {
+      auto& weights = members[i].ruleset.weights;
+
+      weights.alignment = weightDist(engine);
+      weights.coherence = weightDist(engine);
+      weights.separation = weightDist(engine);
+
+//      0 would draw a random flock
+      members[i].seed = static_cast <std::uint32_t> (config.seed + i);
+
+      if ( members[i].seed == 0 )
+        members[i].seed = 1;
+    }
+
+    const auto begin = Clock::now();
+
+    if ( simulateEnsemble(config, members, results.data()) == false )
+    {
+      std::cout << "invalid member config or out of memory\n";
+      result = 2;
+    }
+
+    const auto seconds = double_s{Clock::now() - begin}.count();
+
+    std::size_t completedCount {};
+
+    for ( std::size_t i {}; i < results.length(); ++i )
+      completedCount += results[i].completed;
+
+    if ( result == 0 )
+    {
+      std::cout <<
+        completedCount << " of " << config.memberCount << " flocks of " <<
+        config.boidCount << " boids, " << config.frameCount << " frames each, in " <<
+        seconds << " s on " << config.threadCount + 1 << " threads\n";
+
+      std::cout <<
+        completedCount / seconds << " flocks/s, " <<
+        completedCount * config.boidCount * config.frameCount / seconds / 1'000'000.0 <<
+        " M boid steps/s\n";
+
+      if ( completedCount < config.memberCount )
+        result = 1;
+    }
+
+    const auto file = result != 2
+      ? std::fopen(config.summaryPath, "w")
+      : nullptr;
+
+    if ( file != nullptr )
+    {
+      std::fprintf(file,
+        "member,seed,alignment,coherence,separation,polarization,spread,time_us,completed\n" );
+
+      for ( std::size_t i {}; i < members.length(); ++i )
+      {
+        const auto& weights = members[i].ruleset.weights;
+        const auto& memberResult = results[i];
+
+        std::fprintf(file,
+          "%zu,%u,%.6f,%.6f,%.6f,%.6f,%.6f,%.1f,%d\n",
+          i, members[i].seed,
+          weights.alignment, weights.coherence, weights.separation,
+          memberResult.polarization, memberResult.spread,
+          memberResult.time, memberResult.completed ? 1 : 0 );
+      }
+
+      std::fclose(file);
+
+      std::cout << "wrote " << config.summaryPath << "\n";
+    }
+
+    else if ( result != 2 )
+    {
+      std::cout << "can't write " << config.summaryPath << "\n";
+      result = 2;
+    }
+  }
+
+  allocator.free();
+
+  return result;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "Boids.hpp"
+#include "Containers.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+struct EnsembleConfig
+{
+//  every member simulates a flock of this size for frameCount steps,
+//  on one thread and with the rest of SimulationConfig's defaults
+  std::size_t boidCount {4096};
+  std::size_t cellPerAxisCount {16};
+  std::size_t frameCount {240};
+  float delta {1.f / 240.f};
+
+//  workers besides the calling thread, each runs whole members
+  std::size_t threadCount {3};
+
+//  runEnsemble() draws each member's rule weights from
+//  [0, maxWeight), member i spawns with seed + i
+  std::size_t memberCount {256};
+  float maxWeight {0.3f};
+  std::uint32_t seed {1};
+
+//  one line per member, relative to the working directory
+  const char* summaryPath {"ensemble.csv"};
+};
+
+struct EnsembleMember
+{
+  BoidRuleset ruleset {};
+
+//  0 draws a random flock, see SimulationConfig::seed
+  std::uint32_t seed {1};
+};
+
+//  a member's flock after its last step
+struct EnsembleResult
+{
+//  length of the mean velocity over the mean speed,
+//  1 if every boid heads the same way
+  float polarization {};
+
+//  root mean square distance of the boids from their centroid
+  float spread {};
+
+//  spent initializing, stepping and releasing the member
+  double time {};
+
+  bool completed {};
+};
+
+
+//  Simulates independent flocks, one per thread at a time: whole members
+//  are handed out to the pool's workers and the caller, each of which
+//  steps its member without further synchronization. Every thread owns a
+//  slot of one arena sized for a member, the members it runs are carved
+//  from that slot one after another, so memory doesn't grow with the
+//  member count. Results are indexed like members, false if the arena
+//  can't be reserved
+bool simulateEnsemble(
+  const EnsembleConfig&,
+  const ArrayView <EnsembleMember>&,
+  EnsembleResult* results );
+
+//  Runs a parameter study of memberCount members, writes every member's
+//  weights and results to summaryPath and prints the throughput in
+//  flocks per second. Returns the process exit code: 0 if all members
+//  completed, 1 if some didn't, 2 if the study couldn't run
+int runEnsemble( const EnsembleConfig& );
@@ -0,0 +1,64 @@
+#include "FastMath.hpp"
+
+#include <algorithm>
+
+
+NormalizeError
+measureNormalizeError(
+  const std::size_t directionCount )
+{
+  const float scales []
+  {
+    1e-3f, 1e-2f, 0.1f, 1.f, 10.f, 1e2f, 1e3f,
+  };
+
+//  Fibonacci lattice, consecutive points advance by the golden angle
+  const auto goldenAngle =
+    3.14159265f * (3.f - std::sqrt(5.f));
+
+  NormalizeError error {};
+  double errorSum {};
+
+  for ( std::size_t i {}; i < directionCount; ++i )
+  {
+    const auto z =
+      1.f - 2.f * (i + 0.5f) / directionCount;
+
+    const auto radius =
+      std::sqrt(std::max(0.f, 1.f - z * z));
+
+    const auto angle = goldenAngle * i;
+
+    const Vector3 direction
+    {
+      radius * std::cos(angle),
+      radius * std::sin(angle),
+      z,
+    };
+
+    for ( const auto scale : scales )
+    {
+      const auto vector = direction * scale;
+
+      const auto exact = vector.normalized();
+      const auto approximate = normalizeFast(vector);
+
+      const auto vectorError =
+        (approximate - exact).length();
+
+      const auto lengthError =
+        std::abs(approximate.length() - 1.f);
+
+      error.maxError = std::max(error.maxError, vectorError);
+      error.maxLengthError = std::max(error.maxLengthError, lengthError);
+      errorSum += vectorError;
+
+      ++error.sampleCount;
+    }
+  }
+
+  if ( error.sampleCount > 0 )
+    error.meanError = errorSum / error.sampleCount;
+
+  return error;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Vector.hpp"
+
+#include <limits>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define FAST_MATH_SSE
+#endif
+
+
+enum class NormalizeMode
+{
+  Exact,       // sqrt and division, correctly rounded
+  Approximate, // hardware estimate refined by one Newton step
+};
+
+//  builds configure the default with BOIDS_APPROXIMATE_NORMALIZE
+#if defined(BOIDS_APPROXIMATE_NORMALIZE)
+constexpr NormalizeMode DefaultNormalizeMode {NormalizeMode::Approximate};
+#else
+constexpr NormalizeMode DefaultNormalizeMode {NormalizeMode::Exact};
+#endif
+
+
+//  1 / sqrt(x) for normal x > 0 within about 5e-7 relative error:
+//  rsqrtss is exact to 12 bits, one Newton step doubles that
+inline float
+rsqrt(
+  const float x )
+{
+#if defined(FAST_MATH_SSE)
+  const auto estimate =
+    _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+
+  return estimate * (1.5f - 0.5f * x * estimate * estimate);
+#else
+  return 1.f / std::sqrt(x);
+#endif
+}
+
+//  1 / x for normal x within about 5e-7 relative error
+inline float
+reciprocal(
+  const float x )
+{
+#if defined(FAST_MATH_SSE)
+  const auto estimate =
+    _mm_cvtss_f32(_mm_rcp_ss(_mm_set_ss(x)));
+
+  return estimate * (2.f - x * estimate);
+#else
+  return 1.f / x;
+#endif
+}
+
+inline float
+fastLength(
+  const Vector3& vector )
+{
+  const auto lengthSquared = vector.length_squared();
+
+  if ( lengthSquared < std::numeric_limits <float>::min() )
+    return vector.length();
+
+  return lengthSquared * rsqrt(lengthSquared);
+}
+
+//  squared lengths too small for the estimate,
+//  including 0, take the exact path
+inline Vector3
+normalizeFast(
+  const Vector3& vector )
+{
+  const auto lengthSquared = vector.length_squared();
+
+  if ( lengthSquared < std::numeric_limits <float>::min() )
+    return vector.normalized();
+
+  return vector * rsqrt(lengthSquared);
+}
+
+inline Vector3
+Vector3::normalized_fast() const
+{
+  return normalizeFast(*this);
+}
+
+template <NormalizeMode Mode>
+inline Vector3
+normalize(
+  const Vector3& vector )
+{
+  if constexpr ( Mode == NormalizeMode::Approximate )
+    return normalizeFast(vector);
+
+  else
+    return vector.normalized();
+}
+
+//  largest length a normalized vector may have in the given mode
+template <NormalizeMode Mode>
+constexpr float UnitLengthBound =
+  Mode == NormalizeMode::Approximate
+    ? 1.f + 1e-6f
+    : 1.f;
+
+
+struct NormalizeError
+{
+  std::size_t sampleCount {};
+
+//  distance between the approximate and the exact unit vector
+  float maxError {};
+  float meanError {};
+
+//  deviation of the approximate vector's length from 1
+  float maxLengthError {};
+};
+
+//  compares the approximate normalization against the exact one for
+//  directions spread evenly over the unit sphere, each scaled to
+//  lengths between 1e-3 and 1e3
+NormalizeError measureNormalizeError(
+  const std::size_t directionCount );
@@ -0,0 +1,194 @@
+#include "FlowField.hpp"
+
+#include <cassert>
+#include <cmath>
+
+
+FlowField::FlowField(
+  AllocatorArena& allocator,
+  const std::size_t maxSourceCount )
+  : sources{allocator, maxSourceCount}
+  , staticField{allocator, NodeCount}
+  , field{allocator, NodeCount}
+{
+}
+
+bool
+FlowField::addSource(
+  const FlowSource& source )
+{
+  if ( sourceCount == sources.length() )
+    return false;
+
+  sources[sourceCount++] = source;
+
+  if ( source.isStatic == false )
+    hasDynamicSources = true;
+
+  return true;
+}
+
+void
+FlowField::bakeStatic()
+{
+  std::fill_n(
+    staticField.data(),
+    staticField.length(),
+    Vector3{} );
+
+  for ( std::size_t i {}; i < sourceCount; ++i )
+    if ( sources[i].isStatic == true )
+      splat(sources[i], staticField.data());
+
+  std::copy_n(
+    staticField.data(),
+    NodeCount,
+    field.data() );
+}
+
+void
+FlowField::update()
+{
+  if ( hasDynamicSources == false )
+    return;
+
+  std::copy_n(
+    staticField.data(),
+    NodeCount,
+    field.data() );
+
+  for ( std::size_t i {}; i < sourceCount; ++i )
+    if ( sources[i].isStatic == false )
+      splat(sources[i], field.data());
+}
+
+bool
+FlowField::empty() const
+{
+  return sourceCount == 0;
+}
+
+void
+FlowField::splat(
+  const FlowSource& source,
+  Vector3* target ) const
+{
+  constexpr auto cellCount = NodesPerAxis - 1;
+  constexpr auto nodeSpacing = 1.f / cellCount;
+
+//  only nodes inside the source's bounds are touched
+  Vector3 boundsMin {};
+  Vector3 boundsMax {};
+
+  switch (source.type)
+  {
+    case FlowSource::Type::Attractor:
+    case FlowSource::Type::Repulsor:
+    case FlowSource::Type::Wind:
+      boundsMin = source.a - Vector3{source.radius, source.radius, source.radius};
+      boundsMax = source.a + Vector3{source.radius, source.radius, source.radius};
+      break;
+
+    case FlowSource::Type::NoFly:
+      boundsMin = source.a - Vector3{source.radius, source.radius, source.radius};
+      boundsMax = source.b + Vector3{source.radius, source.radius, source.radius};
+      break;
+  }
+
+  const auto toNode =
+  [] ( const float coordinate )
+  {
+    return static_cast <std::size_t> (
+      std::clamp(coordinate * cellCount, 0.f, float(cellCount)) );
+  };
+
+  const auto toNodeCeil =
+  [] ( const float coordinate )
+  {
+    return static_cast <std::size_t> (
+      std::clamp(std::ceil(coordinate * cellCount), 0.f, float(cellCount)) );
+  };
+
+  for ( auto z = toNode(boundsMin.z); z <= toNodeCeil(boundsMax.z); ++z )
+    for ( auto y = toNode(boundsMin.y); y <= toNodeCeil(boundsMax.y); ++y )
+      for ( auto x = toNode(boundsMin.x); x <= toNodeCeil(boundsMax.x); ++x )
+      {
+        const Vector3 node
+        {
+          x * nodeSpacing,
+          y * nodeSpacing,
+          z * nodeSpacing,
+        };
+
+        auto& value = target[x + (y + z * NodesPerAxis) * NodesPerAxis];
+
+        switch (source.type)
+        {
+          case FlowSource::Type::Attractor:
+          case FlowSource::Type::Repulsor:
+          {
+            const auto offset = source.a - node;
+            const auto distance = offset.length();
+
+            if ( distance >= source.radius || distance == 0.f )
+              break;
+
+            const auto falloff =
+              source.strength * (1.f - distance / source.radius);
+
+            const auto sign =
+              source.type == FlowSource::Type::Attractor ? 1.f : -1.f;
+
+            value += offset * (sign * falloff / distance);
+            break;
+          }
+
+          case FlowSource::Type::Wind:
+          {
+            if ( node.x < boundsMin.x || node.x > boundsMax.x ||
+                 node.y < boundsMin.y || node.y > boundsMax.y ||
+                 node.z < boundsMin.z || node.z > boundsMax.z )
+              break;
+
+            value += source.b * source.strength;
+            break;
+          }
+
+          case FlowSource::Type::NoFly:
+          {
+            const auto center = (source.a + source.b) * 0.5f;
+            const auto offset = node - center;
+
+//            strongest inside the volume, fading out over radius
+            const Vector3 outside
+            {
+              std::max(std::max(source.a.x - node.x, node.x - source.b.x), 0.f),
+              std::max(std::max(source.a.y - node.y, node.y - source.b.y), 0.f),
+              std::max(std::max(source.a.z - node.z, node.z - source.b.z), 0.f),
+            };
+
+            const auto distance = outside.length();
+
+            if ( distance >= source.radius && source.radius > 0.f )
+              break;
+
+            const auto falloff = source.radius > 0.f
+              ? source.strength * (1.f - distance / source.radius)
+              : source.strength;
+
+            value += offset.normalized() * falloff;
+            break;
+          }
+        }
+      }
+}
+
+std::size_t
+FlowField::memoryRequirement(
+  const std::size_t maxSourceCount )
+{
+  return
+    sizeof(FlowSource) * maxSourceCount +
+    sizeof(Vector3) * NodeCount * 2 +
+    sizeof(std::size_t) * 3;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Containers.hpp"
+#include "Vector.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+
+struct FlowSource
+{
+  enum class Type : std::uint32_t
+  {
+    Attractor,  // pulls towards a within radius
+    Repulsor,   // pushes away from a within radius, e.g. predators
+    Wind,       // constant direction b inside the box around a, extent radius
+    NoFly,      // pushes out of the box [a, b] within radius of its faces
+  };
+
+  Vector3 a {};
+  Vector3 b {};
+  float radius {};
+  float strength {};
+  Type type {};
+
+//  static sources are splatted once, dynamic ones every frame
+  bool isStatic {};
+};
+
+//  Low-resolution vector grid over the unit cube. Sources are splatted
+//  into the grid nodes, boids sample it with trilinear interpolation,
+//  so the per-boid cost doesn't depend on the number of sources
+struct FlowField
+{
+  static constexpr std::size_t NodesPerAxis {16};
+  static constexpr std::size_t NodeCount {
+    NodesPerAxis * NodesPerAxis * NodesPerAxis };
+
+
+  Array <FlowSource> sources {};
+  std::size_t sourceCount {};
+
+  Array <Vector3> staticField {};
+  Array <Vector3> field {};
+
+  bool hasDynamicSources {};
+
+
+  FlowField() = default;
+
+  FlowField(
+    AllocatorArena&,
+    const std::size_t maxSourceCount );
+
+
+  bool addSource( const FlowSource& );
+
+//  splats static sources, call once after adding them
+  void bakeStatic();
+
+//  rebuilds the field from the baked static part and dynamic sources
+  void update();
+
+  bool empty() const;
+
+  inline Vector3 sample( const Vector3& position ) const;
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t maxSourceCount );
+
+
+private:
+  void splat(
+    const FlowSource&,
+    Vector3* target ) const;
+};
+
+
+inline Vector3
+FlowField::sample(
+  const Vector3& position ) const
+{
+  constexpr auto cellCount = NodesPerAxis - 1;
+
+  const auto nodes = field.data();
+
+  const auto toGrid =
+  [] ( const float coordinate, std::size_t& node )
+  {
+    const auto scaled = std::clamp(
+      coordinate * cellCount, 0.f, float(cellCount) );
+
+    node = std::min(
+      static_cast <std::size_t> (scaled),
+      cellCount - 1 );
+
+    return scaled - node;
+  };
+
+  std::size_t x, y, z;
+
+  const auto tx = toGrid(position.x, x);
+  const auto ty = toGrid(position.y, y);
+  const auto tz = toGrid(position.z, z);
+
+  const auto base = nodes +
+    x + (y + z * NodesPerAxis) * NodesPerAxis;
+
+  const auto lerp =
+  [] ( const Vector3& lhs, const Vector3& rhs, const float t )
+  {
+    return Vector3
+    {
+      lhs.x + (rhs.x - lhs.x) * t,
+      lhs.y + (rhs.y - lhs.y) * t,
+      lhs.z + (rhs.z - lhs.z) * t,
+    };
+  };
+
+  constexpr auto dy = NodesPerAxis;
+  constexpr auto dz = NodesPerAxis * NodesPerAxis;
+
+  const auto y0z0 = lerp(base[0], base[1], tx);
+  const auto y1z0 = lerp(base[dy], base[dy + 1], tx);
+  const auto y0z1 = lerp(base[dz], base[dz + 1], tx);
+  const auto y1z1 = lerp(base[dz + dy], base[dz + dy + 1], tx);
+
+  return lerp(
+    lerp(y0z0, y1z0, ty),
+    lerp(y0z1, y1z1, ty),
+    tz );
+}
@@ -0,0 +1,129 @@
+#include "FrameReader.hpp"
+
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+
+//  Test consumer for the frame ring: follows the publisher, reads every
+//  frame still in the ring in place and reports the flock centroid.
+//  usage: BoidsConsumer [ring name] [report interval]
+int
+main(
+  int argc,
+  char* argv[] )
+{
+  using namespace std::chrono_literals;
+
+  const char* name = argc > 1
+    ? argv[1]
+    : FrameRing::DefaultName;
+
+  std::uint64_t reportInterval {100};
+
+  if ( argc > 2 )
+  {
+    char* end {};
+    reportInterval = std::strtoull(argv[2], &end, 10);
+
+    if ( end == argv[2] || *end != '\0' || reportInterval == 0 )
+    {
+      std::cout <<
+        "usage: " << argv[0] << " [ring name] [report interval]\n" <<
+        "the report interval is a number of frames above 0\n";
+
+      return 1;
+    }
+  }
+
+  FrameReader reader {};
+
+//  the simulation may not have created the ring yet
+  for ( std::size_t attempt {}; attempt < 1000; ++attempt )
+  {
+    if ( reader.open(name) == true )
+      break;
+
+    std::this_thread::sleep_for(10ms);
+  }
+
+  if ( reader.boidCount() == 0 )
+  {
+    std::cout << "no frame ring at " << name << "\n";
+    return 1;
+  }
+
+  std::cout <<
+    "reading " << name <<
+    ", boids " << reader.boidCount() <<
+    ", slots " << reader.slotCount() << "\n";
+
+  std::uint64_t next = reader.publishedCount();
+  std::uint64_t readCount {};
+  std::uint64_t skippedCount {};
+  std::uint64_t tornCount {};
+
+  while ( true )
+  {
+    const auto published = reader.publishedCount();
+
+    if ( next >= published )
+    {
+      if ( reader.isClosed() == true )
+        break;
+
+      std::this_thread::sleep_for(1ms);
+      continue;
+    }
+
+//    fell behind by more than the ring holds
+    if ( published - next > reader.slotCount() )
+    {
+      const auto oldest = published - reader.slotCount();
+
+      skippedCount += oldest - next;
+      next = oldest;
+    }
+
+    FrameView view {};
+
+    if ( reader.acquire(next, view) == false )
+    {
+      ++skippedCount;
+      ++next;
+      continue;
+    }
+
+    Vector3 centroid {};
+
+    for ( std::size_t i {}; i < view.boidCount; ++i )
+      centroid += view.positions[i];
+
+    centroid /= view.boidCount;
+
+    const auto frame = view.frame;
+
+    if ( reader.validate(view) == false )
+    {
+      ++tornCount;
+      ++next;
+      continue;
+    }
+
+    if ( readCount++ % reportInterval == 0 )
+      std::cout <<
+        "frame " << frame <<
+        " centroid " << centroid.x << ", " << centroid.y << ", " << centroid.z << "\n";
+
+    ++next;
+  }
+
+  std::cout <<
+    "read " << readCount <<
+    ", skipped " << skippedCount <<
+    ", torn " << tornCount << "\n";
+
+  return 0;
+}
@@ -0,0 +1,157 @@
+#include "FramePipeline.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+FramePipeline::FramePipeline(
+  AllocatorArena& allocator,
+  const std::size_t boidCount,
+  const std::size_t depth,
+  const std::size_t recordCount )
+  : positions{allocator, boidCount * depth}
+  , velocities{allocator, boidCount * depth}
+  , records{allocator, depth > 0 ? recordCount : 0}
+  , slotBusy{allocator, depth}
+  , boidCount{boidCount}
+{
+}
+
+std::size_t
+FramePipeline::depth() const
+{
+  return slotBusy.length();
+}
+
+bool
+FramePipeline::enabled() const
+{
+  return depth() > 0;
+}
+
+void
+FramePipeline::submit(
+  ThreadPool& threadPool,
+  const BoidData& boids,
+  const std::size_t frame )
+{
+  assert(enabled() == true);
+
+  const auto slot = submittedCount++ % depth();
+
+  auto& busy = slotBusy[slot];
+
+  threadPool.waitUntil(
+  [&busy]
+  {
+    return busy.load() == false;
+  });
+
+  busy = true;
+  capturePending = true;
+
+  threadPool.pushDetached(
+  [this, &threadPool, &boids, slot, frame] ( const std::size_t )
+  {
+    capture(boids, slot);
+
+    if ( publisher != nullptr )
+      publisher->publish(
+        frame, boids.position.data(), boids.velocity.data() );
+
+    capturePending = false;
+    threadPool.notifyWaiters();
+
+    record(slot, frame);
+
+    slotBusy[slot] = false;
+  });
+}
+
+void
+FramePipeline::waitForCapture(
+  ThreadPool& threadPool ) const
+{
+  threadPool.waitUntil(
+  [this]
+  {
+    return capturePending.load() == false;
+  });
+}
+
+void
+FramePipeline::drain(
+  ThreadPool& threadPool ) const
+{
+  for ( std::size_t slot {}; slot < depth(); ++slot )
+    threadPool.waitUntil(
+    [this, slot]
+    {
+      return slotBusy[slot].load() == false;
+    });
+}
+
+void
+FramePipeline::capture(
+  const BoidData& boids,
+  const std::size_t slot )
+{
+  std::copy_n(
+    boids.position.data(), boidCount,
+    positions.data() + slot * boidCount );
+
+  std::copy_n(
+    boids.velocity.data(), boidCount,
+    velocities.data() + slot * boidCount );
+}
+
+void
+FramePipeline::record(
+  const std::size_t slot,
+  const std::size_t frame )
+{
+  if ( frame >= records.length() || boidCount == 0 )
+    return;
+
+  const auto slotPositions = positions.data() + slot * boidCount;
+  const auto slotVelocities = velocities.data() + slot * boidCount;
+
+  FrameSummary summary {};
+  summary.frame = frame;
+  summary.boundsMin = slotPositions[0];
+  summary.boundsMax = slotPositions[0];
+
+  for ( std::size_t i {}; i < boidCount; ++i )
+  {
+    const auto& position = slotPositions[i];
+
+    summary.centroid += position;
+    summary.meanVelocity += slotVelocities[i];
+
+    summary.boundsMin.x = std::min(summary.boundsMin.x, position.x);
+    summary.boundsMin.y = std::min(summary.boundsMin.y, position.y);
+    summary.boundsMin.z = std::min(summary.boundsMin.z, position.z);
+
+    summary.boundsMax.x = std::max(summary.boundsMax.x, position.x);
+    summary.boundsMax.y = std::max(summary.boundsMax.y, position.y);
+    summary.boundsMax.z = std::max(summary.boundsMax.z, position.z);
+  }
+
+  summary.centroid /= boidCount;
+  summary.meanVelocity /= boidCount;
+
+  records[frame] = summary;
+}
+
+std::size_t
+FramePipeline::memoryRequirement(
+  const std::size_t boidCount,
+  const std::size_t depth,
+  const std::size_t recordCount )
+{
+  return
+    sizeof(Vector3) * boidCount * depth * 2 +
+    sizeof(FrameSummary) * (depth > 0 ? recordCount : 0) +
+    sizeof(std::atomic_bool) * depth +
+    sizeof(std::size_t) * 4;
+}
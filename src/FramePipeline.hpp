@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Boids.hpp"
+#include "ThreadPool.hpp"
+#include "FramePublisher.hpp"
+
+#include <atomic>
+#include <cstddef>
+
+
+//  what the export stage records about every frame
+struct FrameSummary
+{
+  std::size_t frame {};
+
+  Vector3 centroid {};
+  Vector3 meanVelocity {};
+
+  Vector3 boundsMin {};
+  Vector3 boundsMax {};
+};
+
+
+//  Exports frames in the background while the next ones simulate.
+//  submit() hands frame N to a detached pool task which copies positions
+//  and velocities into one of `depth` snapshot slots, then records the
+//  frame's summary from the copy. Frame N + 1 only waits for the copy
+//  before it moves boids, and a slot is reused once the frame exported
+//  into it is done, so at most `depth` frames are in flight.
+//  A publisher, if set, gets every frame during the copy, which
+//  keeps its frames in order without an extra snapshot
+struct FramePipeline
+{
+  Array <Vector3> positions {};
+  Array <Vector3> velocities {};
+
+  Array <FrameSummary> records {};
+  Array <std::atomic_bool> slotBusy {};
+
+  std::atomic_bool capturePending {};
+
+  FramePublisher* publisher {};
+
+  std::size_t boidCount {};
+  std::size_t submittedCount {};
+
+
+  FramePipeline() = default;
+
+  FramePipeline(
+    AllocatorArena&,
+    const std::size_t boidCount,
+    const std::size_t depth,
+    const std::size_t recordCount );
+
+
+  std::size_t depth() const;
+  bool enabled() const;
+
+//  boids must keep their positions and velocities
+//  until waitForCapture() returns
+  void submit(
+    ThreadPool&,
+    const BoidData&,
+    const std::size_t frame );
+
+  void waitForCapture( ThreadPool& ) const;
+
+  void drain( ThreadPool& ) const;
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t boidCount,
+    const std::size_t depth,
+    const std::size_t recordCount );
+
+
+private:
+  void capture(
+    const BoidData&,
+    const std::size_t slot );
+
+  void record(
+    const std::size_t slot,
+    const std::size_t frame );
+};
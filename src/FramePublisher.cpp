@@ -0,0 +1,157 @@
+#include "FramePublisher.hpp"
+
+#include <new>
+#include <cassert>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+
+FramePublisher::~FramePublisher()
+{
+  close();
+}
+
+#if !defined(_WIN32)
+
+bool
+FramePublisher::create(
+  const char* name,
+  const std::size_t boidCount,
+  const std::size_t slotCount )
+{
+  assert(mRegion == nullptr);
+  assert(slotCount > 0);
+
+//  replaces the ring of a previous run, its readers keep the old one
+  shm_unlink(name);
+
+  const auto fd = shm_open(
+    name, O_CREAT | O_EXCL | O_RDWR, 0644 );
+
+  if ( fd < 0 )
+    return false;
+
+  const auto size = FrameRing::regionSize(boidCount, slotCount);
+
+  if ( ftruncate(fd, size) != 0 )
+  {
+    ::close(fd);
+    shm_unlink(name);
+    return false;
+  }
+
+  const auto region = mmap(
+    nullptr, size,
+    PROT_READ | PROT_WRITE, MAP_SHARED,
+    fd, 0 );
+
+  ::close(fd);
+
+  if ( region == MAP_FAILED )
+  {
+    shm_unlink(name);
+    return false;
+  }
+
+  mRegion = region;
+  mRegionSize = size;
+  mBoidCount = boidCount;
+  mSlotCount = slotCount;
+  mName = name;
+
+  auto header = new (mRegion) FrameRing::Header{};
+  header->version = FrameRing::Version;
+  header->boidCount = boidCount;
+  header->slotCount = slotCount;
+
+  for ( std::size_t i {}; i < slotCount; ++i )
+    new (FrameRing::slot(mRegion, boidCount, i)) FrameRing::Slot{};
+
+  header->magic.store(FrameRing::Magic, std::memory_order_release);
+
+  return true;
+}
+
+void
+FramePublisher::close()
+{
+  if ( mRegion == nullptr )
+    return;
+
+  static_cast <FrameRing::Header*> (mRegion)->closed.store(
+    1, std::memory_order_release );
+
+  munmap(mRegion, mRegionSize);
+  shm_unlink(mName);
+
+  mRegion = {};
+  mRegionSize = {};
+}
+
+#else
+
+bool
+FramePublisher::create(
+  const char*,
+  const std::size_t,
+  const std::size_t )
+{
+  return false;
+}
+
+void
+FramePublisher::close()
+{
+}
+
+#endif
+
+bool
+FramePublisher::enabled() const
+{
+  return mRegion != nullptr;
+}
+
+void
+FramePublisher::publish(
+  const std::uint64_t frame,
+  const Vector3* positions,
+  const Vector3* velocities )
+{
+  assert(enabled() == true);
+
+  auto& header = *static_cast <FrameRing::Header*> (mRegion);
+
+  const auto publishedCount =
+    header.publishedCount.load(std::memory_order_relaxed);
+
+  auto slot = FrameRing::slot(
+    mRegion, mBoidCount, publishedCount % mSlotCount );
+
+  const auto sequence =
+    slot->sequence.load(std::memory_order_relaxed);
+
+//  odd while writing, the fence keeps the data stores after it
+  slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot->frame = frame;
+
+  std::memcpy(
+    FrameRing::positions(slot),
+    positions, sizeof(Vector3) * mBoidCount );
+
+  std::memcpy(
+    FrameRing::velocities(slot, mBoidCount),
+    velocities, sizeof(Vector3) * mBoidCount );
+
+  slot->sequence.store(sequence + 2, std::memory_order_release);
+
+  header.publishedCount.store(
+    publishedCount + 1, std::memory_order_release );
+}
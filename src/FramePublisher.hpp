@@ -0,0 +1,45 @@
+#pragma once
+
+#include "FrameRing.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+//  Writes completed frames into a shared memory FrameRing, round robin
+//  over its slots. Readers never block the publisher: a reader still
+//  busy with a slot being overwritten sees its sequence change and
+//  drops or retries the frame. publish() calls must not overlap
+class FramePublisher
+{
+  void* mRegion {};
+  std::size_t mRegionSize {};
+
+  std::size_t mBoidCount {};
+  std::size_t mSlotCount {};
+
+  const char* mName {};
+
+
+public:
+  FramePublisher() = default;
+  FramePublisher( const FramePublisher& ) = delete;
+  ~FramePublisher();
+
+
+  bool create(
+    const char* name,
+    const std::size_t boidCount,
+    const std::size_t slotCount );
+
+//  tells readers no more frames follow and removes the name,
+//  mapped readers keep their view
+  void close();
+
+  bool enabled() const;
+
+  void publish(
+    const std::uint64_t frame,
+    const Vector3* positions,
+    const Vector3* velocities );
+};
@@ -0,0 +1,189 @@
+#include "FrameReader.hpp"
+
+#include <cassert>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+FrameReader::~FrameReader()
+{
+  close();
+}
+
+const FrameRing::Header&
+FrameReader::header() const
+{
+  return *static_cast <const FrameRing::Header*> (mRegion);
+}
+
+#if !defined(_WIN32)
+
+bool
+FrameReader::open(
+  const char* name )
+{
+  assert(mRegion == nullptr);
+
+  const auto fd = shm_open(name, O_RDONLY, 0);
+
+  if ( fd < 0 )
+    return false;
+
+  struct stat info {};
+
+  if ( fstat(fd, &info) != 0 ||
+       static_cast <std::size_t> (info.st_size) < sizeof(FrameRing::Header) )
+  {
+    ::close(fd);
+    return false;
+  }
+
+  const auto region = mmap(
+    nullptr, info.st_size,
+    PROT_READ, MAP_SHARED,
+    fd, 0 );
+
+  ::close(fd);
+
+  if ( region == MAP_FAILED )
+    return false;
+
+  mRegion = region;
+  mRegionSize = info.st_size;
+
+  const auto& header = this->header();
+
+  if ( header.magic.load(std::memory_order_acquire) != FrameRing::Magic ||
+       header.version != FrameRing::Version ||
+       FrameRing::regionSize(header.boidCount, header.slotCount) != mRegionSize )
+  {
+    close();
+    return false;
+  }
+
+  mBoidCount = header.boidCount;
+  mSlotCount = header.slotCount;
+
+  return true;
+}
+
+void
+FrameReader::close()
+{
+  if ( mRegion == nullptr )
+    return;
+
+  munmap(mRegion, mRegionSize);
+
+  mRegion = {};
+  mRegionSize = {};
+}
+
+#else
+
+bool
+FrameReader::open(
+  const char* )
+{
+  return false;
+}
+
+void
+FrameReader::close()
+{
+}
+
+#endif
+
+std::size_t
+FrameReader::boidCount() const
+{
+  return mBoidCount;
+}
+
+std::size_t
+FrameReader::slotCount() const
+{
+  return mSlotCount;
+}
+
+std::uint64_t
+FrameReader::publishedCount() const
+{
+  return header().publishedCount.load(std::memory_order_acquire);
+}
+
+bool
+FrameReader::isClosed() const
+{
+  return header().closed.load(std::memory_order_acquire) != 0;
+}
+
+bool
+FrameReader::acquire(
+  const std::uint64_t publishIndex,
+  FrameView& view ) const
+{
+  const auto published = publishedCount();
+
+  if ( publishIndex >= published ||
+       published - publishIndex > mSlotCount )
+    return false;
+
+//  the ring only maps read-only, the slot is never written through this
+  const auto slot = FrameRing::slot(
+    mRegion, mBoidCount, publishIndex % mSlotCount );
+
+  const auto sequence =
+    slot->sequence.load(std::memory_order_acquire);
+
+  if ( sequence % 2 != 0 )
+    return false;
+
+//  every publish of a slot advances its sequence by 2
+  const auto slotPublishCount =
+    publishIndex / mSlotCount + 1;
+
+  if ( sequence != slotPublishCount * 2 )
+    return false;
+
+  view.frame = slot->frame;
+  view.publishIndex = publishIndex;
+  view.positions = FrameRing::positions(slot);
+  view.velocities = FrameRing::velocities(slot, mBoidCount);
+  view.boidCount = mBoidCount;
+  view.sequence = sequence;
+  view.slot = slot;
+
+  return true;
+}
+
+bool
+FrameReader::acquireLatest(
+  FrameView& view ) const
+{
+  const auto published = publishedCount();
+
+  if ( published == 0 )
+    return false;
+
+  return acquire(published - 1, view);
+}
+
+bool
+FrameReader::validate(
+  const FrameView& view ) const
+{
+  assert(view.slot != nullptr);
+
+//  keeps the data loads before the second sequence check
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  return
+    view.slot->sequence.load(std::memory_order_relaxed) == view.sequence;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "FrameRing.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+//  a frame read in place from the ring, only meaningful
+//  if FrameReader::validate() passes after reading it
+struct FrameView
+{
+  std::uint64_t frame {};
+  std::uint64_t publishIndex {};
+
+  const Vector3* positions {};
+  const Vector3* velocities {};
+  std::size_t boidCount {};
+
+  std::uint64_t sequence {};
+  const FrameRing::Slot* slot {};
+};
+
+
+//  Maps a FrameRing read-only. Frames are read in place without locks:
+//  acquire a view, read what is needed, then validate(). A failed
+//  validation means the publisher reused the slot meanwhile, so the
+//  data read may be torn and has to be dropped or read again
+class FrameReader
+{
+  void* mRegion {};
+  std::size_t mRegionSize {};
+
+  std::size_t mBoidCount {};
+  std::size_t mSlotCount {};
+
+
+  const FrameRing::Header& header() const;
+
+
+public:
+  FrameReader() = default;
+  FrameReader( const FrameReader& ) = delete;
+  ~FrameReader();
+
+
+//  false until the publisher has created and initialized the ring
+  bool open( const char* name = FrameRing::DefaultName );
+
+  void close();
+
+
+  std::size_t boidCount() const;
+  std::size_t slotCount() const;
+
+//  frames published so far, the latest has index publishedCount() - 1
+  std::uint64_t publishedCount() const;
+
+//  the publisher won't publish anything anymore
+  bool isClosed() const;
+
+//  false if the frame isn't published yet, was overwritten
+//  or is being written right now
+  bool acquire(
+    const std::uint64_t publishIndex,
+    FrameView& ) const;
+
+  bool acquireLatest( FrameView& ) const;
+
+  bool validate( const FrameView& ) const;
+};
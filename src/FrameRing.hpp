@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Vector.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+//  Layout of the shared memory ring FramePublisher writes and FrameReader
+//  maps: a header followed by slotCount frame slots. Every slot holds a
+//  seqlock sequence, the frame number, then boidCount positions and
+//  velocities. The sequence is odd while the slot is being written,
+//  readers check it is even and unchanged after reading the frame
+struct FrameRing
+{
+  static constexpr char DefaultName [] {"/boids-frames"};
+
+  static constexpr std::uint32_t Magic {0x73646962}; // "bids"
+  static constexpr std::uint32_t Version {1};
+
+  static constexpr std::size_t CacheLineSize {64};
+
+
+  struct Header
+  {
+//    written last, readers wait for it
+    std::atomic_uint32_t magic {};
+    std::uint32_t version {};
+
+    std::uint64_t boidCount {};
+    std::uint64_t slotCount {};
+
+    alignas(CacheLineSize) std::atomic_uint64_t publishedCount {};
+    std::atomic_uint32_t closed {};
+  };
+
+  struct Slot
+  {
+    alignas(CacheLineSize) std::atomic_uint64_t sequence {};
+    std::uint64_t frame {};
+  };
+
+
+  static std::size_t vectorsBytes( const std::size_t boidCount );
+
+  static std::size_t slotStride( const std::size_t boidCount );
+
+  static std::size_t regionSize(
+    const std::size_t boidCount,
+    const std::size_t slotCount );
+
+  static Slot* slot(
+    void* region,
+    const std::size_t boidCount,
+    const std::size_t slotIndex );
+
+  static Vector3* positions( Slot* );
+
+  static Vector3* velocities(
+    Slot*,
+    const std::size_t boidCount );
+};
+
+static_assert(std::atomic_uint64_t::is_always_lock_free);
+static_assert(std::atomic_uint32_t::is_always_lock_free);
+
+
+inline std::size_t
+FrameRing::vectorsBytes(
+  const std::size_t boidCount )
+{
+  const auto bytes = sizeof(Vector3) * boidCount;
+
+  return (bytes + CacheLineSize - 1) / CacheLineSize * CacheLineSize;
+}
+
+inline std::size_t
+FrameRing::slotStride(
+  const std::size_t boidCount )
+{
+  return sizeof(Slot) + vectorsBytes(boidCount) * 2;
+}
+
+inline std::size_t
+FrameRing::regionSize(
+  const std::size_t boidCount,
+  const std::size_t slotCount )
+{
+  return sizeof(Header) + slotStride(boidCount) * slotCount;
+}
+
+inline FrameRing::Slot*
+FrameRing::slot(
+  void* region,
+  const std::size_t boidCount,
+  const std::size_t slotIndex )
+{
+  return reinterpret_cast <Slot*> (
+    static_cast <std::byte*> (region) +
+    sizeof(Header) +
+    slotStride(boidCount) * slotIndex );
+}
+
+inline Vector3*
+FrameRing::positions(
+  Slot* slot )
+{
+  return reinterpret_cast <Vector3*> (slot + 1);
+}
+
+inline Vector3*
+FrameRing::velocities(
+  Slot* slot,
+  const std::size_t boidCount )
+{
+  return reinterpret_cast <Vector3*> (
+    reinterpret_cast <std::byte*> (slot + 1) + vectorsBytes(boidCount) );
+}
@@ -0,0 +1,145 @@
+#include "GridTuner.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+
+GridOccupancy
+measureOccupancy(
+  const GroupTable& groups,
+  const Array <GroupId>& cells,
+  const std::size_t boidCount )
+{
+  GridOccupancy occupancy {};
+
+  for ( GroupId groupId {}; groupId < groups.count; ++groupId )
+  {
+//    the most recent group of a cell heads its group list
+    if ( cells[groups.cell[groupId]] != groupId )
+      continue;
+
+    std::size_t cellBoidCount {};
+
+    for ( auto cellGroup = groupId;
+          cellGroup != NoGroup;
+          cellGroup = groups.aggregates[cellGroup].next )
+      cellBoidCount += groups.aggregates[cellGroup].count;
+
+    ++occupancy.occupiedCells;
+
+    occupancy.maxBoidsPerCell = std::max(
+      occupancy.maxBoidsPerCell, cellBoidCount );
+  }
+
+  if ( occupancy.occupiedCells > 0 )
+    occupancy.meanBoidsPerCell =
+      float(boidCount) / occupancy.occupiedCells;
+
+  return occupancy;
+}
+
+
+void
+GridTuner::init(
+  const std::size_t initialCellsPerAxis )
+{
+  assert(minCellsPerAxis <= maxCellsPerAxis);
+
+  cellsPerAxis = std::clamp(
+    initialCellsPerAxis,
+    minCellsPerAxis,
+    maxCellsPerAxis );
+
+  committedCellsPerAxis = cellsPerAxis;
+  committedFrameTime = {};
+
+  windowFrames = {};
+  windowFrameTime = {};
+
+  cooldownLeft = {};
+  probeDirection = 1;
+  isProbing = false;
+}
+
+void
+GridTuner::addFrame(
+  const double frameTime )
+{
+  ++windowFrames;
+  windowFrameTime += frameTime;
+}
+
+bool
+GridTuner::windowComplete() const
+{
+  return windowFrames >= interval;
+}
+
+bool
+GridTuner::retune(
+  const GridOccupancy& occupancy )
+{
+  assert(windowFrames > 0);
+
+  const auto averageFrameTime =
+    windowFrameTime / windowFrames;
+
+  windowFrames = {};
+  windowFrameTime = {};
+
+  if ( isProbing == true )
+  {
+    isProbing = false;
+
+    if ( averageFrameTime < committedFrameTime * (1.0 - hysteresis) )
+    {
+      committedCellsPerAxis = cellsPerAxis;
+      committedFrameTime = averageFrameTime;
+
+      return false;
+    }
+
+    cellsPerAxis = committedCellsPerAxis;
+    cooldownLeft = cooldown;
+    probeDirection = -probeDirection;
+
+    return true;
+  }
+
+//  the best resolution drifts as the flock clumps,
+//  so the committed one is re-measured every window
+  committedFrameTime = averageFrameTime;
+
+  if ( cooldownLeft > 0 )
+  {
+    --cooldownLeft;
+    return false;
+  }
+
+  if ( occupancy.meanBoidsPerCell > crowdedOccupancy )
+    probeDirection = 1;
+
+  else if ( occupancy.meanBoidsPerCell < sparseOccupancy )
+    probeDirection = -1;
+
+  const auto candidate = std::clamp(
+    static_cast <std::size_t> (std::lround(probeDirection > 0
+      ? cellsPerAxis * resolutionStep
+      : cellsPerAxis / resolutionStep)),
+    minCellsPerAxis,
+    maxCellsPerAxis );
+
+  if ( candidate == cellsPerAxis )
+  {
+    probeDirection = -probeDirection;
+    cooldownLeft = cooldown;
+
+    return false;
+  }
+
+  cellsPerAxis = candidate;
+  isProbing = true;
+
+  return true;
+}
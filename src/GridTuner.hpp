@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Boids.hpp"
+
+#include <cstddef>
+
+
+struct GridOccupancy
+{
+  std::size_t occupiedCells {};
+  std::size_t maxBoidsPerCell {};
+  float meanBoidsPerCell {};
+};
+
+GridOccupancy measureOccupancy(
+  const GroupTable&,
+  const Array <GroupId>& cells,
+  const std::size_t boidCount );
+
+
+//  Picks the grid resolution by measurement: every `interval` frames the
+//  average frame time of the current resolution is refreshed and a
+//  neighboring resolution is probed for one window, in the direction the
+//  occupancy statistics suggest. A probe is kept only if it beats the
+//  current resolution by `hysteresis`, a rejected probe pauses probing
+//  for `cooldown` windows
+struct GridTuner
+{
+  std::size_t minCellsPerAxis {16};
+  std::size_t maxCellsPerAxis {128};
+
+  std::size_t interval {30};
+  std::size_t cooldown {4};
+
+  float hysteresis {0.05f};
+  float resolutionStep {1.25f};
+
+//  mean boids per occupied cell outside this range
+//  makes the next probe go coarser or finer
+  float sparseOccupancy {1.5f};
+  float crowdedOccupancy {8.f};
+
+  std::size_t cellsPerAxis {};
+
+
+  void init( const std::size_t initialCellsPerAxis );
+
+  void addFrame( const double frameTime );
+
+  bool windowComplete() const;
+
+//  returns true if cellsPerAxis changed
+  bool retune( const GridOccupancy& );
+
+
+private:
+  std::size_t committedCellsPerAxis {};
+  double committedFrameTime {};
+
+  std::size_t windowFrames {};
+  double windowFrameTime {};
+
+  std::size_t cooldownLeft {};
+  int probeDirection {1};
+  bool isProbing {};
+};
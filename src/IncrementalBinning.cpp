@@ -0,0 +1,147 @@
+#include "IncrementalBinning.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+IncrementalBinning::IncrementalBinning(
+  AllocatorArena& allocator,
+  const std::size_t boidCount,
+  const std::size_t groupCapacity )
+  : binnedPosition{allocator, boidCount}
+  , binnedVelocity{allocator, boidCount}
+  , freeGroups{allocator, boidCount > 0 ? groupCapacity : 0}
+  , movers{allocator, boidCount}
+{
+}
+
+void
+IncrementalBinning::init(
+  const BoidData& boids )
+{
+  const auto boidCount = boids.position.length();
+
+  std::copy_n(boids.position.data(), boidCount, binnedPosition.data());
+  std::copy_n(boids.velocity.data(), boidCount, binnedVelocity.data());
+
+  freeGroupCount = {};
+  moverCount = {};
+}
+
+void
+IncrementalBinning::moveBoids(
+  BoidData& boids,
+  GroupTable& groups,
+  Array <GroupId>& cells )
+{
+  const auto count = moverCount.exchange(0);
+
+//  movers take their old contribution along,
+//  the update pass then adds the change since binning
+  for ( std::size_t j {}; j < count; ++j )
+  {
+    const auto i = movers[j];
+
+    auto groupId = boids.groupId[i];
+    auto* group = &groups.aggregates[groupId];
+
+    group->position -= binnedPosition[i];
+    group->velocity -= binnedVelocity[i];
+
+    if ( --group->count == 0 )
+      releaseGroup(groups, cells, groupId);
+
+    groupId = acquireGroup(
+      groups, cells, boids.cellId[i], boids.species[i] );
+
+    group = &groups.aggregates[groupId];
+
+    group->position += binnedPosition[i];
+    group->velocity += binnedVelocity[i];
+    ++group->count;
+
+    boids.groupId[i] = groupId;
+  }
+}
+
+void
+IncrementalBinning::updateGroups(
+  const BoidData& boids,
+  GroupTable& groups,
+  const std::size_t rangeStart,
+  const std::size_t rangeEnd )
+{
+  for ( auto i = rangeStart; i < rangeEnd; ++i )
+  {
+    const auto& position = boids.position[i];
+    const auto& velocity = boids.velocity[i];
+
+    auto& group = groups.aggregates[boids.groupId[i]];
+
+    group.position += position - binnedPosition[i];
+    group.velocity += velocity - binnedVelocity[i];
+
+    binnedPosition[i] = position;
+    binnedVelocity[i] = velocity;
+  }
+}
+
+void
+IncrementalBinning::releaseGroup(
+  GroupTable& groups,
+  Array <GroupId>& cells,
+  const GroupId groupId )
+{
+  auto* link = &cells[groups.cell[groupId]];
+
+//  a cell holds at most one group per species
+  while ( *link != groupId )
+  {
+    assert(*link != NoGroup);
+    link = &groups.aggregates[*link].next;
+  }
+
+  *link = groups.aggregates[groupId].next;
+
+  freeGroups[freeGroupCount++] = groupId;
+}
+
+GroupId
+IncrementalBinning::acquireGroup(
+  GroupTable& groups,
+  Array <GroupId>& cells,
+  const std::uint32_t cellId,
+  const SpeciesId species )
+{
+  for ( auto groupId = cells[cellId];
+        groupId != NoGroup;
+        groupId = groups.aggregates[groupId].next )
+    if ( groups.species[groupId] == species )
+      return groupId;
+
+  if ( freeGroupCount == 0 )
+    return cells[cellId] = groups.create(cellId, species, cells[cellId]);
+
+//  emptied groups stay numbered, refilling them keeps count from growing
+  const auto groupId = freeGroups[--freeGroupCount];
+
+  groups.aggregates[groupId] = {{}, {}, 0, cells[cellId]};
+  groups.cell[groupId] = cellId;
+  groups.species[groupId] = species;
+
+  cells[cellId] = groupId;
+
+  return groupId;
+}
+
+std::size_t
+IncrementalBinning::memoryRequirement(
+  const std::size_t boidCount,
+  const std::size_t groupCapacity )
+{
+  return
+    sizeof(Vector3) * boidCount * 2 +
+    sizeof(GroupId) * (boidCount > 0 ? groupCapacity : 0) +
+    sizeof(std::uint32_t) * boidCount +
+    sizeof(std::size_t) * 4;
+}
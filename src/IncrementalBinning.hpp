@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Boids.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+//  Keeps grid groups alive between frames instead of rebuilding them.
+//  The transform pass reports each boid's new cell and collects the ones
+//  that left their group's cell, moveBoids() relinks only those, then the
+//  aggregates are updated by the change of each boid's contribution.
+//  Emptied groups are unlinked and their ids reused before the table
+//  grows, until the next full rebuild numbers the groups densely again
+struct IncrementalBinning
+{
+//  each boid's contribution as it was last added to its group
+  Array <Vector3> binnedPosition {};
+  Array <Vector3> binnedVelocity {};
+
+//  stack of unused group ids below the table's count
+  Array <GroupId> freeGroups {};
+  std::size_t freeGroupCount {};
+
+  Array <std::uint32_t> movers {};
+  std::atomic_size_t moverCount {};
+
+
+  IncrementalBinning() = default;
+
+  IncrementalBinning(
+    AllocatorArena&,
+    const std::size_t boidCount,
+    const std::size_t groupCapacity );
+
+
+//  adopts the groups of a full rebuild
+  void init( const BoidData& );
+
+//  thread-safe, called by the transform pass
+  inline void updateCell(
+    BoidData&,
+    const GroupTable&,
+    const std::size_t boidId,
+    const std::uint32_t cellId );
+
+  void moveBoids(
+    BoidData&,
+    GroupTable&,
+    Array <GroupId>& cells );
+
+  void updateGroups(
+    const BoidData&,
+    GroupTable&,
+    const std::size_t rangeStart,
+    const std::size_t rangeEnd );
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t boidCount,
+    const std::size_t groupCapacity );
+
+
+private:
+  void releaseGroup(
+    GroupTable&,
+    Array <GroupId>& cells,
+    const GroupId );
+
+  GroupId acquireGroup(
+    GroupTable&,
+    Array <GroupId>& cells,
+    const std::uint32_t cellId,
+    const SpeciesId );
+};
+
+
+inline void
+IncrementalBinning::updateCell(
+  BoidData& boids,
+  const GroupTable& groups,
+  const std::size_t boidId,
+  const std::uint32_t cellId )
+{
+  boids.cellId[boidId] = cellId;
+
+  if ( groups.cell[boids.groupId[boidId]] != cellId )
+    movers[moverCount.fetch_add(1, std::memory_order_relaxed)] =
+      static_cast <std::uint32_t> (boidId);
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <new>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+
+//  Move-only, type-erased callable stored in a fixed inline buffer.
+//  Unlike std::function it never touches the heap: a callable that
+//  doesn't fit into Capacity bytes is a compile error
+template <typename Signature, std::size_t Capacity = 128>
+class InlineTask;
+
+template <typename Result, typename... Args, std::size_t Capacity>
+class InlineTask <Result( Args... ), Capacity>
+{
+  using Invoker = Result (*)( void*, Args&&... );
+
+//  moves the callable from the second pointer into the first one
+//  and destroys the source, destroys the callable if target is null
+  using Manager = void (*)( void* target, void* source );
+
+  alignas(std::max_align_t) unsigned char mStorage [Capacity];
+
+  Invoker mInvoke {};
+  Manager mManage {};
+
+
+  template <typename F>
+  static Result invoke( void*, Args&&... );
+
+  template <typename F>
+  static void manage( void* target, void* source );
+
+
+public:
+  static constexpr std::size_t capacity {Capacity};
+
+
+  InlineTask() noexcept = default;
+  InlineTask( std::nullptr_t ) noexcept;
+  InlineTask( InlineTask&& ) noexcept;
+  InlineTask( const InlineTask& ) = delete;
+
+  template <typename F, typename = std::enable_if_t <
+    std::is_same_v <std::decay_t <F>, InlineTask> == false>>
+  InlineTask( F&& ) noexcept;
+
+  ~InlineTask() noexcept;
+
+
+  InlineTask& operator = ( InlineTask&& ) noexcept;
+  InlineTask& operator = ( std::nullptr_t ) noexcept;
+
+  Result operator () ( Args... );
+
+  bool operator == ( std::nullptr_t ) const noexcept;
+  bool operator != ( std::nullptr_t ) const noexcept;
+};
+
+
+template <typename Result, typename... Args, std::size_t Capacity>
+template <typename F>
+Result
+InlineTask <Result( Args... ), Capacity>::invoke(
+  void* callable,
+  Args&&... args )
+{
+  return (*static_cast <F*> (callable))(std::forward <Args> (args)...);
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+template <typename F>
+void
+InlineTask <Result( Args... ), Capacity>::manage(
+  void* target,
+  void* source )
+{
+  auto callable = static_cast <F*> (source);
+
+  if ( target != nullptr )
+    new (target) F{std::move(*callable)};
+
+  callable->~F();
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+InlineTask <Result( Args... ), Capacity>::InlineTask(
+  std::nullptr_t ) noexcept
+{
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+InlineTask <Result( Args... ), Capacity>::InlineTask(
+  InlineTask&& other ) noexcept
+{
+  *this = std::move(other);
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+template <typename F, typename>
+InlineTask <Result( Args... ), Capacity>::InlineTask(
+  F&& callable ) noexcept
+{
+  using Callable = std::decay_t <F>;
+
+  static_assert(sizeof(Callable) <= Capacity,
+    "callable doesn't fit into the task buffer, capture less or by reference" );
+
+  static_assert(alignof(Callable) <= alignof(std::max_align_t));
+
+  static_assert(std::is_nothrow_move_constructible_v <Callable>);
+
+  new (mStorage) Callable{std::forward <F> (callable)};
+
+  mInvoke = &invoke <Callable>;
+  mManage = &manage <Callable>;
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+InlineTask <Result( Args... ), Capacity>::~InlineTask() noexcept
+{
+  *this = nullptr;
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+InlineTask <Result( Args... ), Capacity>&
+InlineTask <Result( Args... ), Capacity>::operator = (
+  InlineTask&& other ) noexcept
+{
+  if ( this == &other )
+    return *this;
+
+  *this = nullptr;
+
+  if ( other.mManage == nullptr )
+    return *this;
+
+  other.mManage(mStorage, other.mStorage);
+
+  mInvoke = std::exchange(other.mInvoke, nullptr);
+  mManage = std::exchange(other.mManage, nullptr);
+
+  return *this;
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+InlineTask <Result( Args... ), Capacity>&
+InlineTask <Result( Args... ), Capacity>::operator = (
+  std::nullptr_t ) noexcept
+{
+  if ( mManage != nullptr )
+    mManage(nullptr, mStorage);
+
+  mInvoke = {};
+  mManage = {};
+
+  return *this;
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+Result
+InlineTask <Result( Args... ), Capacity>::operator () (
+  Args... args )
+{
+  assert(mInvoke != nullptr);
+
+  return mInvoke(mStorage, std::forward <Args> (args)...);
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+bool
+InlineTask <Result( Args... ), Capacity>::operator == (
+  std::nullptr_t ) const noexcept
+{
+  return mInvoke == nullptr;
+}
+
+template <typename Result, typename... Args, std::size_t Capacity>
+bool
+InlineTask <Result( Args... ), Capacity>::operator != (
+  std::nullptr_t ) const noexcept
+{
+  return mInvoke != nullptr;
+}
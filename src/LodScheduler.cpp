@@ -0,0 +1,28 @@
+#include "LodScheduler.hpp"
+
+#include <cassert>
+
+
+LodScheduler::LodScheduler(
+  AllocatorArena& allocator,
+  const std::size_t boidCount )
+  : tiers{allocator, boidCount}
+{
+  for ( std::size_t i {}; i < MaxTierCount; ++i )
+    assert(IsPowerOfTwo(tierIntervals[i]));
+}
+
+bool
+LodScheduler::enabled() const
+{
+  return tiers.length() > 0 && tierCount > 1;
+}
+
+std::size_t
+LodScheduler::memoryRequirement(
+  const std::size_t boidCount )
+{
+  return
+    sizeof(Tier) * boidCount +
+    sizeof(std::size_t);
+}
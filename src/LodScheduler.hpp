@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Containers.hpp"
+#include "Vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+//  Temporal level of detail: every boid belongs to an update tier,
+//  tier t runs the steering rules every tierIntervals[t]-th frame and
+//  only integrates its last steering in between. Phases are staggered
+//  by boid index, so each frame updates an even share of every tier
+struct LodScheduler
+{
+  static constexpr std::size_t MaxTierCount {4};
+  static constexpr std::size_t MaxIntervalShift {3};
+
+  using Tier = std::uint8_t;
+
+
+  Vector3 focusPoint {0.5f, 0.5f, 0.5f};
+
+//  boids farther than tierDistances[t] from the focus point
+//  fall into tier t + 1, intervals must be powers of two
+  float tierDistances [MaxTierCount - 1] {0.25f, 0.5f, 0.75f};
+  std::size_t tierIntervals [MaxTierCount] {1, 2, 4, 8};
+  std::size_t tierCount {3};
+
+//  stretches every tier's interval by 2^intervalShift,
+//  lowers the steering rate without reclassifying boids
+  std::size_t intervalShift {};
+
+//  boids whose velocity changed by less than this per frame
+//  drop one more tier, 0 disables the criterion
+  float stableVelocityChange {};
+
+  Array <Tier> tiers {};
+
+
+  LodScheduler() = default;
+
+  LodScheduler(
+    AllocatorArena&,
+    const std::size_t boidCount );
+
+
+  bool enabled() const;
+
+  inline Tier classify(
+    const Vector3& position,
+    const Vector3& velocityChange ) const;
+
+  inline bool isDue(
+    const std::size_t boidId,
+    const std::size_t frame ) const;
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t boidCount );
+};
+
+
+inline LodScheduler::Tier
+LodScheduler::classify(
+  const Vector3& position,
+  const Vector3& velocityChange ) const
+{
+  const auto focusDistanceSquared =
+    (position - focusPoint).length_squared();
+
+  Tier tier {};
+
+  while ( tier + 1u < tierCount &&
+          focusDistanceSquared > tierDistances[tier] * tierDistances[tier] )
+    ++tier;
+
+  if ( tier + 1u < tierCount &&
+       velocityChange.length_squared() < stableVelocityChange * stableVelocityChange )
+    ++tier;
+
+  return tier;
+}
+
+inline bool
+LodScheduler::isDue(
+  const std::size_t boidId,
+  const std::size_t frame ) const
+{
+  const auto interval =
+    tierIntervals[tiers.data()[boidId]] << intervalShift;
+
+  return ((frame + boidId) & (interval - 1)) == 0;
+}
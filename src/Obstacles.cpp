@@ -0,0 +1,437 @@
+#include "Obstacles.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+
+
+namespace
+{
+
+Vector3
+min(
+  const Vector3& lhs,
+  const Vector3& rhs )
+{
+  return
+  {
+    std::min(lhs.x, rhs.x),
+    std::min(lhs.y, rhs.y),
+    std::min(lhs.z, rhs.z),
+  };
+}
+
+Vector3
+max(
+  const Vector3& lhs,
+  const Vector3& rhs )
+{
+  return
+  {
+    std::max(lhs.x, rhs.x),
+    std::max(lhs.y, rhs.y),
+    std::max(lhs.z, rhs.z),
+  };
+}
+
+Vector3
+clamp(
+  const Vector3& point,
+  const Vector3& boundsMin,
+  const Vector3& boundsMax )
+{
+  return min(max(point, boundsMin), boundsMax);
+}
+
+//  kept scalar, it runs for every visited node
+inline float
+boundsDistanceSquared(
+  const Vector3& point,
+  const Vector3& boundsMin,
+  const Vector3& boundsMax )
+{
+  const auto dx = std::max(std::max(boundsMin.x - point.x, point.x - boundsMax.x), 0.f);
+  const auto dy = std::max(std::max(boundsMin.y - point.y, point.y - boundsMax.y), 0.f);
+  const auto dz = std::max(std::max(boundsMin.z - point.z, point.z - boundsMax.z), 0.f);
+
+  return dx * dx + dy * dy + dz * dz;
+}
+
+inline float
+surfaceDistance(
+  const Vector3& offset,
+  const float radius,
+  Vector3& direction )
+{
+  const auto length = offset.length();
+
+  direction = length > 0.f
+    ? offset / length
+    : Vector3{};
+
+  return length - radius;
+}
+
+float
+axis(
+  const Vector3& vector,
+  const std::size_t index )
+{
+  return (&vector.x)[index];
+}
+
+} // namespace
+
+
+Vector3
+Obstacle::boundsMin() const
+{
+  switch (type)
+  {
+    case Type::Sphere:
+      return a - Vector3{radius, radius, radius};
+
+    case Type::Capsule:
+      return min(a, b) - Vector3{radius, radius, radius};
+
+    case Type::Box:
+      return a;
+  }
+
+  return {};
+}
+
+Vector3
+Obstacle::boundsMax() const
+{
+  switch (type)
+  {
+    case Type::Sphere:
+      return a + Vector3{radius, radius, radius};
+
+    case Type::Capsule:
+      return max(a, b) + Vector3{radius, radius, radius};
+
+    case Type::Box:
+      return b;
+  }
+
+  return {};
+}
+
+float
+Obstacle::distance(
+  const Vector3& point,
+  Vector3& direction ) const
+{
+  switch (type)
+  {
+    case Type::Sphere:
+    {
+      return surfaceDistance(
+        point - a, radius, direction );
+    }
+
+    case Type::Capsule:
+    {
+      const auto segment = b - a;
+      const auto segmentLengthSquared = segment.length_squared();
+
+      const auto t = segmentLengthSquared > 0.f
+        ? std::clamp((point - a).dot(segment) / segmentLengthSquared, 0.f, 1.f)
+        : 0.f;
+
+      return surfaceDistance(
+        point - (a + segment * t), radius, direction );
+    }
+
+    case Type::Box:
+    {
+      const auto closest = clamp(point, a, b);
+      const auto offset = point - closest;
+
+      if ( offset.length_squared() > 0.f )
+        return surfaceDistance(
+          offset, 0.f, direction );
+
+//      inside, push out through the nearest face
+      float nearest = point.x - a.x;
+      direction = {-1.f, 0.f, 0.f};
+
+      const float faces[]
+      {
+        b.x - point.x,
+        point.y - a.y, b.y - point.y,
+        point.z - a.z, b.z - point.z,
+      };
+
+      const Vector3 normals[]
+      {
+        {1.f, 0.f, 0.f},
+        {0.f, -1.f, 0.f}, {0.f, 1.f, 0.f},
+        {0.f, 0.f, -1.f}, {0.f, 0.f, 1.f},
+      };
+
+      for ( std::size_t i {}; i < std::size(faces); ++i )
+        if ( faces[i] < nearest )
+        {
+          nearest = faces[i];
+          direction = normals[i];
+        }
+
+      return -nearest;
+    }
+  }
+
+  return {};
+}
+
+
+ObstacleScene::ObstacleScene(
+  AllocatorArena& allocator,
+  const std::size_t obstacleCount )
+  : obstacles{allocator, obstacleCount}
+  , nodes{allocator, obstacleCount > 0 ? obstacleCount * 2 - 1 : 0}
+  , cullCells{allocator, CullCellsPerAxis * CullCellsPerAxis * CullCellsPerAxis}
+{
+}
+
+void
+ObstacleScene::build(
+  const float distance )
+{
+  influenceDistance = distance;
+  nodeCount = {};
+
+  std::fill_n(
+    cullCells.data(),
+    cullCells.length(),
+    std::uint8_t{} );
+
+  if ( empty() == true )
+    return;
+
+  buildNode(0, obstacles.length());
+
+  const Vector3 margin {distance, distance, distance};
+
+  for ( std::size_t i {}; i < obstacles.length(); ++i )
+  {
+    const auto cellMin = clamp(
+      obstacles[i].boundsMin() - margin, {}, {1.f, 1.f, 1.f} );
+
+    const auto cellMax = clamp(
+      obstacles[i].boundsMax() + margin, {}, {1.f, 1.f, 1.f} );
+
+    const auto toCell =
+    [] ( const float coordinate )
+    {
+      return std::min(
+        static_cast <std::size_t> (coordinate * CullCellsPerAxis),
+        CullCellsPerAxis - 1 );
+    };
+
+    for ( auto z = toCell(cellMin.z); z <= toCell(cellMax.z); ++z )
+      for ( auto y = toCell(cellMin.y); y <= toCell(cellMax.y); ++y )
+        for ( auto x = toCell(cellMin.x); x <= toCell(cellMax.x); ++x )
+          cullCells[x + (y + z * CullCellsPerAxis) * CullCellsPerAxis] = 1;
+  }
+}
+
+std::size_t
+ObstacleScene::buildNode(
+  const std::size_t begin,
+  const std::size_t end )
+{
+  const auto nodeId = nodeCount++;
+
+  assert(nodeId < nodes.length());
+
+  auto& node = nodes[nodeId];
+
+  node.boundsMin = obstacles[begin].boundsMin();
+  node.boundsMax = obstacles[begin].boundsMax();
+
+  Vector3 centroidMin = (obstacles[begin].boundsMin() + obstacles[begin].boundsMax()) * 0.5f;
+  Vector3 centroidMax = centroidMin;
+
+  for ( auto i = begin + 1; i < end; ++i )
+  {
+    const auto boundsMin = obstacles[i].boundsMin();
+    const auto boundsMax = obstacles[i].boundsMax();
+    const auto centroid = (boundsMin + boundsMax) * 0.5f;
+
+    node.boundsMin = min(node.boundsMin, boundsMin);
+    node.boundsMax = max(node.boundsMax, boundsMax);
+    centroidMin = min(centroidMin, centroid);
+    centroidMax = max(centroidMax, centroid);
+  }
+
+  if ( end - begin <= LeafSize )
+  {
+    node.offset = begin;
+    node.count = end - begin;
+
+    return nodeId;
+  }
+
+//  median split along the widest centroid axis
+  const auto extent = centroidMax - centroidMin;
+
+  std::size_t splitAxis {};
+
+  if ( extent.y > axis(extent, splitAxis) )
+    splitAxis = 1;
+
+  if ( extent.z > axis(extent, splitAxis) )
+    splitAxis = 2;
+
+  const auto middle = begin + (end - begin) / 2;
+
+  std::nth_element(
+    obstacles.data() + begin,
+    obstacles.data() + middle,
+    obstacles.data() + end,
+  [splitAxis] ( const Obstacle& lhs, const Obstacle& rhs )
+  {
+    return
+      axis(lhs.boundsMin() + lhs.boundsMax(), splitAxis) <
+      axis(rhs.boundsMin() + rhs.boundsMax(), splitAxis);
+  });
+
+  buildNode(begin, middle);
+
+  node.offset = buildNode(middle, end);
+  node.count = 0;
+
+  return nodeId;
+}
+
+void
+ObstacleScene::queryAvoidance(
+  const Vector3* positions,
+  Vector3* avoidance,
+  const std::size_t rangeStart,
+  const std::size_t rangeEnd,
+  const float distance ) const
+{
+  if ( empty() == true )
+    return;
+
+  assert(distance <= influenceDistance);
+
+  const auto nodeData = nodes.data();
+  const auto obstacleData = obstacles.data();
+  const auto cullData = cullCells.data();
+
+  std::uint32_t stack [64];
+
+  for ( auto i = rangeStart; i < rangeEnd; ++i )
+  {
+    const auto& position = positions[i];
+
+    if ( cullData[cullCellId(position)] == 0 )
+      continue;
+
+    auto nearestDistance = distance;
+    Vector3 nearestDirection {};
+
+    std::size_t stackSize {};
+    stack[stackSize++] = 0;
+
+    while ( stackSize > 0 )
+    {
+      const auto& node = nodeData[stack[--stackSize]];
+
+      const auto boundsDistance = boundsDistanceSquared(
+        position, node.boundsMin, node.boundsMax );
+
+      const auto searchRadius =
+        std::max(nearestDistance, 0.f);
+
+      if ( boundsDistance > searchRadius * searchRadius )
+        continue;
+
+      if ( node.count == 0 )
+      {
+        assert(stackSize + 2 <= std::size(stack));
+
+        std::uint32_t nearChild = &node - nodeData + 1;
+        std::uint32_t farChild = node.offset;
+
+        auto nearDistance = boundsDistanceSquared(
+          position, nodeData[nearChild].boundsMin, nodeData[nearChild].boundsMax );
+
+        auto farDistance = boundsDistanceSquared(
+          position, nodeData[farChild].boundsMin, nodeData[farChild].boundsMax );
+
+        if ( farDistance < nearDistance )
+        {
+          std::swap(nearChild, farChild);
+          std::swap(nearDistance, farDistance);
+        }
+
+//        near child is popped first so the search radius shrinks early
+        if ( farDistance <= searchRadius * searchRadius )
+          stack[stackSize++] = farChild;
+
+        if ( nearDistance <= searchRadius * searchRadius )
+          stack[stackSize++] = nearChild;
+
+        continue;
+      }
+
+      for ( auto j = node.offset; j < node.offset + node.count; ++j )
+      {
+        Vector3 direction {};
+
+        const auto obstacleDistance =
+          obstacleData[j].distance(position, direction);
+
+        if ( obstacleDistance < nearestDistance )
+        {
+          nearestDistance = obstacleDistance;
+          nearestDirection = direction;
+        }
+      }
+    }
+
+    avoidance[i] += nearestDirection;
+  }
+}
+
+bool
+ObstacleScene::empty() const
+{
+  return obstacles.length() == 0;
+}
+
+std::size_t
+ObstacleScene::cullCellId(
+  const Vector3& position ) const
+{
+  const auto toCell =
+  [] ( const float coordinate )
+  {
+    return std::min(
+      static_cast <std::size_t> (coordinate * CullCellsPerAxis),
+      CullCellsPerAxis - 1 );
+  };
+
+  return
+    toCell(position.x) +
+    toCell(position.y) * CullCellsPerAxis +
+    toCell(position.z) * CullCellsPerAxis * CullCellsPerAxis;
+}
+
+std::size_t
+ObstacleScene::memoryRequirement(
+  const std::size_t obstacleCount )
+{
+  return
+    sizeof(Obstacle) * obstacleCount +
+    sizeof(BvhNode) * obstacleCount * 2 + 32 +
+    CullCellsPerAxis * CullCellsPerAxis * CullCellsPerAxis +
+    sizeof(std::size_t) * 3;
+}
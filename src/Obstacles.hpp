@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Containers.hpp"
+#include "Vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+struct Obstacle
+{
+  enum class Type : std::uint32_t
+  {
+    Sphere,   // center a
+    Capsule,  // segment a-b
+    Box,      // axis-aligned, min a, max b
+  };
+
+  Vector3 a {};
+  Vector3 b {};
+  float radius {};
+  Type type {};
+
+
+  Vector3 boundsMin() const;
+  Vector3 boundsMax() const;
+
+//  returns distance to the surface, negative inside,
+//  direction points away from the surface
+  float distance( const Vector3& point, Vector3& direction ) const;
+};
+
+//  leaf nodes reference `count` obstacles starting at `offset`,
+//  inner nodes have count 0, their first child follows them
+//  and the second one lives at `offset`
+struct BvhNode
+{
+  Vector3 boundsMin {};
+  std::uint32_t offset {};
+  Vector3 boundsMax {};
+  std::uint32_t count {};
+};
+
+//  Static obstacle scene inside the unit cube. The hierarchy is built once
+//  and packed depth-first into a flat node array, a coarse cull grid marks
+//  the cells an obstacle can influence so most boids never touch the BVH
+struct ObstacleScene
+{
+  static constexpr std::size_t LeafSize {4};
+  static constexpr std::size_t CullCellsPerAxis {32};
+
+
+  Array <Obstacle> obstacles {};
+  Array <BvhNode, 32> nodes {};
+  Array <std::uint8_t> cullCells {};
+
+  std::size_t nodeCount {};
+  float influenceDistance {};
+
+
+  ObstacleScene() = default;
+
+  ObstacleScene(
+    AllocatorArena&,
+    const std::size_t obstacleCount );
+
+
+  void build( const float influenceDistance );
+
+//  adds the direction away from the nearest obstacle closer than
+//  `distance` to avoidance[i] for every i in [rangeStart, rangeEnd)
+  void queryAvoidance(
+    const Vector3* positions,
+    Vector3* avoidance,
+    const std::size_t rangeStart,
+    const std::size_t rangeEnd,
+    const float distance ) const;
+
+  bool empty() const;
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t obstacleCount );
+
+
+private:
+  std::size_t buildNode(
+    const std::size_t begin,
+    const std::size_t end );
+
+  std::size_t cullCellId( const Vector3& ) const;
+};
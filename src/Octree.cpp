@@ -0,0 +1,190 @@
+#include "Octree.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+
+namespace
+{
+
+//  inserts two zero bits between each of the lower 10 bits
+std::uint32_t
+spreadBits(
+  std::uint32_t value )
+{
+  value = (value | (value << 16)) & 0x030000FF;
+  value = (value | (value <<  8)) & 0x0300F00F;
+  value = (value | (value <<  4)) & 0x030C30C3;
+  value = (value | (value <<  2)) & 0x09249249;
+
+  return value;
+}
+
+} // namespace
+
+
+MortonOctree::MortonOctree(
+  AllocatorArena& allocator,
+  const std::size_t boidCount )
+  : keys{allocator, boidCount}
+  , keysScratch{allocator, boidCount}
+  , order{allocator, boidCount}
+  , orderScratch{allocator, boidCount}
+{
+}
+
+void
+MortonOctree::reset()
+{
+  leafCount = {};
+  maxLeafDepth = {};
+}
+
+void
+MortonOctree::build(
+  const Vector3* positions,
+  std::uint32_t* groupId,
+  const std::size_t rangeStart,
+  const std::size_t rangeEnd )
+{
+  if ( rangeStart == rangeEnd )
+    return;
+
+  auto keysIn = keys.data();
+  auto keysOut = keysScratch.data();
+  auto orderIn = order.data();
+  auto orderOut = orderScratch.data();
+
+  for ( auto i = rangeStart; i < rangeEnd; ++i )
+  {
+    keysIn[i] = mortonKey(positions[i]);
+    orderIn[i] = i;
+  }
+
+//  LSD radix sort, 8 bits per pass over the 30-bit keys
+  constexpr std::size_t keyBits {MaxDepth * 3};
+  constexpr std::size_t digitBits {8};
+  constexpr std::size_t digitCount {1 << digitBits};
+
+  for ( std::size_t shift {}; shift < keyBits; shift += digitBits )
+  {
+    std::size_t offsets [digitCount] {};
+
+    for ( auto i = rangeStart; i < rangeEnd; ++i )
+      ++offsets[(keysIn[i] >> shift) & (digitCount - 1)];
+
+    for ( std::size_t digit {}, offset = rangeStart; digit < digitCount; ++digit )
+      offset += std::exchange(offsets[digit], offset);
+
+    for ( auto i = rangeStart; i < rangeEnd; ++i )
+    {
+      const auto target =
+        offsets[(keysIn[i] >> shift) & (digitCount - 1)]++;
+
+      keysOut[target] = keysIn[i];
+      orderOut[target] = orderIn[i];
+    }
+
+    std::swap(keysIn, keysOut);
+    std::swap(orderIn, orderOut);
+  }
+
+  struct Node
+  {
+    std::size_t begin;
+    std::size_t end;
+    std::size_t depth;
+  };
+
+  Node stack [MaxDepth * 7 + 1];
+  std::size_t stackSize {};
+
+  stack[stackSize++] = {rangeStart, rangeEnd, 0};
+
+  while ( stackSize > 0 )
+  {
+    const auto node = stack[--stackSize];
+
+    if ( node.end - node.begin <= leafCapacity ||
+         node.depth == MaxDepth )
+    {
+      const auto leafId = static_cast <std::uint32_t> (leafCount);
+
+      for ( auto i = node.begin; i < node.end; ++i )
+        groupId[orderIn[i]] = leafId;
+
+      ++leafCount;
+      maxLeafDepth = std::max(maxLeafDepth, node.depth);
+
+      continue;
+    }
+
+//    keys in the node share their top 3 * depth bits,
+//    the next 3 bits select the child
+    const auto childShift = (MaxDepth - node.depth - 1) * 3;
+    const auto nodePrefix = keysIn[node.begin] >> (childShift + 3) << (childShift + 3);
+
+    auto childBegin = node.begin;
+
+    for ( std::uint32_t child {}; child < 8; ++child )
+    {
+      const auto childLimit =
+        nodePrefix + ((child + 1) << childShift);
+
+      const auto childEnd = child == 7
+        ? node.end
+        : std::lower_bound(
+            keysIn + childBegin,
+            keysIn + node.end,
+            childLimit ) - keysIn;
+
+      if ( childEnd > childBegin )
+      {
+        assert(stackSize < std::size(stack));
+
+        stack[stackSize++] = {childBegin, std::size_t(childEnd), node.depth + 1};
+      }
+
+      childBegin = childEnd;
+    }
+  }
+
+//  an odd pass count leaves the sorted data in the scratch arrays,
+//  keep `keys` and `order` holding the sorted range
+  if ( keysIn != keys.data() )
+  {
+    std::copy(keysIn + rangeStart, keysIn + rangeEnd, keys.data() + rangeStart);
+    std::copy(orderIn + rangeStart, orderIn + rangeEnd, order.data() + rangeStart);
+  }
+}
+
+std::uint32_t
+MortonOctree::mortonKey(
+  const Vector3& position )
+{
+  constexpr std::uint32_t cellCount {1 << MaxDepth};
+
+  const auto toCell =
+  [] ( const float coordinate )
+  {
+    return std::min(
+      static_cast <std::uint32_t> (std::max(coordinate, 0.f) * cellCount),
+      cellCount - 1 );
+  };
+
+  return
+    spreadBits(toCell(position.x)) |
+    spreadBits(toCell(position.y)) << 1 |
+    spreadBits(toCell(position.z)) << 2;
+}
+
+std::size_t
+MortonOctree::memoryRequirement(
+  const std::size_t boidCount )
+{
+  return
+    sizeof(std::uint32_t) * boidCount * 4 +
+    sizeof(std::size_t) * 4;
+}
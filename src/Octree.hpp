@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Containers.hpp"
+#include "Vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+
+//  Linear octree over the unit cube built from radix-sorted Morton keys.
+//  Nodes are split until they hold at most leafCapacity boids, so leaves
+//  are small inside dense clusters and large in sparse regions.
+//  Every boid gets the index of its leaf, leaves of all ranges built
+//  since reset() are numbered densely and serve as the aggregate groups
+struct MortonOctree
+{
+  static constexpr std::size_t MaxDepth {10};
+
+  std::size_t leafCapacity {32};
+
+
+  Array <std::uint32_t> keys {};
+  Array <std::uint32_t> keysScratch {};
+
+  Array <std::uint32_t> order {};
+  Array <std::uint32_t> orderScratch {};
+
+  std::size_t leafCount {};
+  std::size_t maxLeafDepth {};
+
+
+  MortonOctree() = default;
+
+  MortonOctree(
+    AllocatorArena&,
+    const std::size_t boidCount );
+
+
+  void reset();
+
+//  builds leaves for boids [rangeStart, rangeEnd),
+//  disjoint ranges are indexed independently
+  void build(
+    const Vector3* positions,
+    std::uint32_t* groupId,
+    const std::size_t rangeStart,
+    const std::size_t rangeEnd );
+
+
+  static std::uint32_t mortonKey( const Vector3& );
+
+  static std::size_t memoryRequirement(
+    const std::size_t boidCount );
+};
@@ -23,6 +23,9 @@ struct PerformanceCounter
 
   diff_type elapsed {};
 
+//  the range the last update() closed
+  diff_type last {};
+
   printable_type average {};
 
   size_t hits {};
@@ -56,7 +59,8 @@ struct PerformanceCounter
 
   inline bool update( const size_t steps )
   {
-    elapsed += range.end - range.begin;
+    last = range.end - range.begin;
+    elapsed += last;
     range.begin = {};
     range.end = {};
 
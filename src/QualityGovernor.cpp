@@ -0,0 +1,89 @@
+#include "QualityGovernor.hpp"
+#include "LodScheduler.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+
+void
+QualityGovernor::init(
+  const SimulationConfig& config,
+  const std::size_t maxSubsteps,
+  const std::size_t maxLodIntervalShift )
+{
+  assert(maxSubsteps > 0);
+  assert(degradeShare > restoreShare);
+
+  const auto lodIntervalShift = config.temporalLod
+    ? std::min(maxLodIntervalShift, LodScheduler::MaxIntervalShift)
+    : 0;
+
+  levelCount = {};
+
+//  ladders longer than MaxLevelCount lose their cheapest levels
+  const auto addLevel =
+  [this] ( const std::size_t stencilRadius, const std::size_t shift, const std::size_t substeps )
+  {
+    if ( levelCount < MaxLevelCount )
+      levels[levelCount++] = {{stencilRadius, shift}, substeps};
+  };
+
+  addLevel(config.stencilRadius, 0, maxSubsteps);
+
+  for ( std::size_t shift {1}; shift <= lodIntervalShift; ++shift )
+    addLevel(config.stencilRadius, shift, maxSubsteps);
+
+  for ( auto radius = config.stencilRadius; radius > 0; --radius )
+    addLevel(radius - 1, lodIntervalShift, maxSubsteps);
+
+  for ( auto substeps = maxSubsteps; substeps > 1; --substeps )
+    addLevel(0, lodIntervalShift, substeps - 1);
+
+  level = {};
+  calmFrames = {};
+  cooldownLeft = {};
+}
+
+const QualityLevel&
+QualityGovernor::quality() const
+{
+  assert(level < levelCount);
+
+  return levels[level];
+}
+
+bool
+QualityGovernor::addFrame(
+  const double frameWork )
+{
+  if ( cooldownLeft > 0 )
+    --cooldownLeft;
+
+  if ( frameWork > frameBudget * degradeShare )
+  {
+    calmFrames = {};
+
+    if ( level + 1 == levelCount )
+      return false;
+
+    ++level;
+    cooldownLeft = cooldown;
+
+    return true;
+  }
+
+  if ( frameWork < frameBudget * restoreShare )
+    ++calmFrames;
+  else
+    calmFrames = {};
+
+  if ( level == 0 ||
+       cooldownLeft > 0 ||
+       calmFrames < restoreFrameCount )
+    return false;
+
+  --level;
+  calmFrames = {};
+
+  return true;
+}
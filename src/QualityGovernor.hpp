@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Simulation.hpp"
+
+#include <cstddef>
+
+
+struct QualityLevel
+{
+  SimulationQuality simulation {};
+
+//  fixed steps a presented frame may run,
+//  time due beyond them is dropped
+  std::size_t maxSubsteps {};
+};
+
+
+//  Keeps frames inside a time budget by trading quality for time. Levels
+//  run from the config's full quality down: stretched LOD tiers first,
+//  then a shrinking stencil, then fewer substeps, which slows the flock
+//  down instead of the frames. A single frame whose work exceeds
+//  degradeShare of the budget drops one level. Going back up takes
+//  restoreFrameCount frames in a row under restoreShare, and is blocked
+//  for `cooldown` frames after a drop, so a level that just proved too
+//  slow isn't retried right away
+struct QualityGovernor
+{
+  static constexpr std::size_t MaxLevelCount {16};
+
+//  microseconds, like the perf counters
+  double frameBudget {1'000'000.0 / 60.0};
+
+  float degradeShare {0.8f};
+  float restoreShare {0.5f};
+
+  std::size_t restoreFrameCount {60};
+  std::size_t cooldown {120};
+
+  QualityLevel levels [MaxLevelCount] {};
+  std::size_t levelCount {};
+
+//  index into levels, higher is cheaper
+  std::size_t level {};
+
+
+  void init(
+    const SimulationConfig&,
+    const std::size_t maxSubsteps,
+    const std::size_t maxLodIntervalShift );
+
+  const QualityLevel& quality() const;
+
+//  returns true if the level changed
+  bool addFrame( const double frameWork );
+
+
+private:
+  std::size_t calmFrames {};
+  std::size_t cooldownLeft {};
+};
@@ -0,0 +1,402 @@
+#include "QueueCheck.hpp"
+#include "Containers.hpp"
+#include "Allocators.hpp"
+#include "PerformanceCounter.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <iostream>
+
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+//  producer index in the high half, its sequence number in the low one
+using Item = std::uint64_t;
+
+
+Item
+makeItem(
+  const std::size_t producer,
+  const std::size_t sequence )
+{
+  return static_cast <Item> (producer) << 32 | sequence;
+}
+
+std::size_t
+itemProducer(
+  const Item item )
+{
+  return item >> 32;
+}
+
+std::size_t
+itemSequence(
+  const Item item )
+{
+  return item & 0xffffffff;
+}
+
+
+//  the reference the lock-free rings are measured against
+class LockedQueue
+{
+  Array <Item> mSlots {};
+  std::size_t mHead {};
+  std::size_t mTail {};
+  std::mutex mMutex {};
+
+
+public:
+
+  LockedQueue(
+    AllocatorArena& allocator,
+    const std::size_t capacity )
+    : mSlots{allocator, capacity}
+  {
+  }
+
+  bool tryPush(
+    const Item& item )
+  {
+    std::lock_guard lock {mMutex};
+
+    if ( mTail - mHead == mSlots.length() )
+      return false;
+
+    mSlots[mTail++ % mSlots.length()] = item;
+
+    return true;
+  }
+
+  bool tryPop(
+    Item& item )
+  {
+    std::lock_guard lock {mMutex};
+
+    if ( mHead == mTail )
+      return false;
+
+    item = mSlots[mHead++ % mSlots.length()];
+
+    return true;
+  }
+
+  static std::size_t memoryRequirement(
+    const std::size_t capacity )
+  {
+    return
+      sizeof(Item) * capacity +
+      sizeof(std::size_t);
+  }
+};
+
+
+bool
+stressSpsc(
+  AllocatorArena& allocator,
+  const QueueCheckConfig& config )
+{
+  SpscQueue <Item> queue {allocator, config.stressCapacity};
+
+  const auto itemCount = config.itemCount;
+
+  std::thread producer
+  {
+    [&queue, itemCount]
+    {
+      for ( std::size_t i {}; i < itemCount; ++i )
+        while ( queue.tryPush(makeItem(0, i)) == false )
+          std::this_thread::yield();
+    }
+  };
+
+  std::size_t mismatchCount {};
+
+  for ( std::size_t i {}; i < itemCount; ++i )
+  {
+    Item item {};
+
+    while ( queue.tryPop(item) == false )
+      std::this_thread::yield();
+
+    if ( item != makeItem(0, i) )
+      ++mismatchCount;
+  }
+
+  producer.join();
+
+  Item item {};
+
+  const bool passed =
+    mismatchCount == 0 &&
+    queue.tryPop(item) == false;
+
+  std::cout <<
+    "spsc stress 1:1: " << mismatchCount << " out of order, " <<
+    (passed ? "passed" : "FAILED") << "\n";
+
+  return passed;
+}
+
+bool
+stressMpmc(
+  AllocatorArena& allocator,
+  const QueueCheckConfig& config,
+  const std::size_t producerCount,
+  const std::size_t consumerCount )
+{
+  const auto itemCount = config.itemCount;
+  const auto totalCount = producerCount * itemCount;
+
+  MpmcQueue <Item> queue {allocator, config.stressCapacity};
+
+//  how often every item arrived, and the next sequence
+//  each consumer may see from each producer
+  Array <std::atomic_uint8_t> arrivals {allocator, totalCount};
+  Array <std::size_t> nextSequences {allocator, consumerCount * producerCount};
+  Array <std::thread> threads {allocator, producerCount + consumerCount};
+
+  std::atomic_size_t poppedCount {};
+  std::atomic_size_t misorderedCount {};
+
+  for ( std::size_t p {}; p < producerCount; ++p )
+    threads[p] = std::thread
+    {
+      [&queue, p, itemCount]
+      {
+        for ( std::size_t i {}; i < itemCount; ++i )
+          while ( queue.tryPush(makeItem(p, i)) == false )
+            std::this_thread::yield();
+      }
+    };
+
+  for ( std::size_t c {}; c < consumerCount; ++c )
+    threads[producerCount + c] = std::thread
+    {
+      [&, c]
+      {
+        auto nextSequence = nextSequences.data() + c * producerCount;
+
+        while ( poppedCount.load(std::memory_order_relaxed) < totalCount )
+        {
+          Item item {};
+
+          if ( queue.tryPop(item) == false )
+          {
+            std::this_thread::yield();
+            continue;
+          }
+
+          poppedCount.fetch_add(1, std::memory_order_relaxed);
+
+          const auto producer = itemProducer(item);
+          const auto sequence = itemSequence(item);
+
+          if ( producer >= producerCount || sequence >= itemCount )
+          {
+            misorderedCount.fetch_add(1, std::memory_order_relaxed);
+            continue;
+          }
+
+          if ( sequence < nextSequence[producer] )
+            misorderedCount.fetch_add(1, std::memory_order_relaxed);
+
+          nextSequence[producer] = sequence + 1;
+
+          arrivals[producer * itemCount + sequence].fetch_add(
+            1, std::memory_order_relaxed );
+        }
+      }
+    };
+
+  for ( std::size_t i {}; i < threads.length(); ++i )
+    threads[i].join();
+
+  std::size_t lostCount {};
+  std::size_t duplicateCount {};
+
+  for ( std::size_t i {}; i < totalCount; ++i )
+  {
+    const auto arrivalCount = arrivals[i].load(std::memory_order_relaxed);
+
+    lostCount += arrivalCount == 0;
+    duplicateCount += arrivalCount > 1;
+  }
+
+  const bool passed =
+    lostCount == 0 &&
+    duplicateCount == 0 &&
+    misorderedCount == 0;
+
+  std::cout <<
+    "mpmc stress " << producerCount << ":" << consumerCount << ": " <<
+    lostCount << " lost, " <<
+    duplicateCount << " duplicated, " <<
+    misorderedCount << " out of order, " <<
+    (passed ? "passed" : "FAILED") << "\n";
+
+  return passed;
+}
+
+
+//  items per second moved from the producers to the consumers
+template <typename Queue>
+double
+measureThroughput(
+  AllocatorArena& allocator,
+  Queue& queue,
+  const std::size_t producerCount,
+  const std::size_t consumerCount,
+  const std::size_t itemCount )
+{
+  const auto totalCount = producerCount * itemCount;
+
+  Array <std::thread> threads {allocator, producerCount + consumerCount};
+
+  std::atomic_size_t poppedCount {};
+  std::atomic_bool started {};
+
+  for ( std::size_t p {}; p < producerCount; ++p )
+    threads[p] = std::thread
+    {
+      [&queue, &started, p, itemCount]
+      {
+        while ( started.load(std::memory_order_acquire) == false )
+          std::this_thread::yield();
+
+        for ( std::size_t i {}; i < itemCount; ++i )
+          while ( queue.tryPush(makeItem(p, i)) == false )
+            std::this_thread::yield();
+      }
+    };
+
+  for ( std::size_t c {}; c < consumerCount; ++c )
+    threads[producerCount + c] = std::thread
+    {
+      [&queue, &started, &poppedCount, totalCount]
+      {
+        while ( started.load(std::memory_order_acquire) == false )
+          std::this_thread::yield();
+
+        while ( poppedCount.load(std::memory_order_relaxed) < totalCount )
+        {
+          Item item {};
+
+          if ( queue.tryPop(item) == true )
+            poppedCount.fetch_add(1, std::memory_order_relaxed);
+          else
+            std::this_thread::yield();
+        }
+      }
+    };
+
+  const auto begin = Clock::now();
+
+  started.store(true, std::memory_order_release);
+
+  for ( std::size_t i {}; i < threads.length(); ++i )
+    threads[i].join();
+
+  const auto seconds = double_s{Clock::now() - begin}.count();
+
+  return totalCount / seconds;
+}
+
+void
+printThroughput(
+  const char* queueName,
+  const std::size_t producerCount,
+  const std::size_t consumerCount,
+  const double itemsPerSecond )
+{
+  std::printf(
+    "%-8s %zu:%zu %10.2f Mitems/s\n",
+    queueName, producerCount, consumerCount,
+    itemsPerSecond / 1'000'000.0 );
+}
+}
+
+
+int
+runQueueChecks(
+  const QueueCheckConfig& config )
+{
+  const auto maxThreadCount = config.maxThreadCount;
+
+  if ( config.stressCapacity == 0 ||
+       IsPowerOfTwo(config.stressCapacity) == false ||
+       config.benchmarkCapacity == 0 ||
+       IsPowerOfTwo(config.benchmarkCapacity) == false ||
+       maxThreadCount == 0 ||
+       config.itemCount > 0xffffffff ||
+       config.benchmarkItemCount > 0xffffffff )
+  {
+    std::cout << "queue checks need power of two capacities, threads and 32-bit item counts\n";
+    return 2;
+  }
+
+  const auto capacity = std::max(
+    config.stressCapacity, config.benchmarkCapacity );
+
+  AllocatorArena allocator {};
+
+  if ( allocator.reserve(
+        MpmcQueue <Item>::memoryRequirement(capacity) +
+        LockedQueue::memoryRequirement(capacity) +
+        sizeof(std::atomic_uint8_t) * maxThreadCount * config.itemCount +
+        sizeof(std::size_t) * maxThreadCount * maxThreadCount +
+        sizeof(std::thread) * maxThreadCount * 2 +
+        sizeof(std::size_t) * 8 ) == false )
+  {
+    std::cout << "out of memory\n";
+    return 2;
+  }
+
+  bool passed = stressSpsc(allocator, config);
+
+  for ( std::size_t producers {1}; producers <= maxThreadCount; ++producers )
+  for ( std::size_t consumers {1}; consumers <= maxThreadCount; ++consumers )
+    passed = stressMpmc(allocator, config, producers, consumers) && passed;
+
+  if ( passed == true )
+  {
+    const auto itemCount = config.benchmarkItemCount;
+
+    {
+      SpscQueue <Item> queue {allocator, config.benchmarkCapacity};
+
+      printThroughput("spsc", 1, 1,
+        measureThroughput(allocator, queue, 1, 1, itemCount) );
+    }
+
+//    thread counts double up to maxThreadCount
+    for ( std::size_t threads {1}; threads <= maxThreadCount; threads *= 2 )
+    {
+      {
+        MpmcQueue <Item> queue {allocator, config.benchmarkCapacity};
+
+        printThroughput("mpmc", threads, threads,
+          measureThroughput(allocator, queue, threads, threads, itemCount / threads) );
+      }
+
+      {
+        LockedQueue queue {allocator, config.benchmarkCapacity};
+
+        printThroughput("locked", threads, threads,
+          measureThroughput(allocator, queue, threads, threads, itemCount / threads) );
+      }
+    }
+  }
+
+  allocator.free();
+
+  std::cout << "queue checks " << (passed ? "passed" : "failed") << "\n";
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+
+
+struct QueueCheckConfig
+{
+//  Stress runs push itemCount items per producer through small rings,
+//  so threads keep running into full and empty rings. Every item must
+//  arrive exactly once and in its producer's order
+  std::size_t stressCapacity {16};
+  std::size_t itemCount {200'000};
+
+//  MPMC stress runs every producer and consumer count up to this
+  std::size_t maxThreadCount {4};
+
+//  throughput runs move benchmarkItemCount items per producer through
+//  rings of benchmarkCapacity, next to a mutex guarded ring of the same
+//  size for reference
+  std::size_t benchmarkCapacity {1024};
+  std::size_t benchmarkItemCount {2'000'000};
+};
+
+//  Runs the stress checks of SpscQueue and MpmcQueue, then prints their
+//  throughput. Returns the process exit code: 0 if every check passed,
+//  1 if one failed, 2 without the memory to run them
+int runQueueChecks( const QueueCheckConfig& );
@@ -0,0 +1,269 @@
+#include "Realtime.hpp"
+#include "QualityGovernor.hpp"
+#include "PerformanceCounter.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+
+std::size_t
+FixedTimestep::advance(
+  const double frameTime,
+  const std::size_t maxSteps )
+{
+  assert(step > 0.0);
+
+  accumulator += frameTime;
+
+  const auto dueSteps =
+    static_cast <std::size_t> (accumulator / step);
+
+  const auto steps = std::min(dueSteps, maxSteps);
+
+  accumulator -= step * steps;
+
+//  keeps the fraction of a step, so the interpolation stays continuous
+  if ( dueSteps > steps )
+  {
+    const auto remainder = std::fmod(accumulator, step);
+
+    droppedTime += accumulator - remainder;
+    accumulator = remainder;
+  }
+
+  return steps;
+}
+
+float
+FixedTimestep::alpha() const
+{
+  return std::clamp(
+    static_cast <float> (accumulator / step), 0.f, 1.f );
+}
+
+void
+interpolatePositions(
+  const ArrayView <Vector3>& previous,
+  const ArrayView <Vector3>& current,
+  const float alpha,
+  const BoundaryMode boundary,
+  Vector3* output )
+{
+  assert(previous.length() == current.length());
+
+  const auto shortest =
+  [] ( const float offset )
+  {
+    return offset - std::round(offset);
+  };
+
+  const auto wrap =
+  [] ( const float coordinate )
+  {
+    const auto wrapped =
+      coordinate - std::floor(coordinate);
+
+    return wrapped < 1.f ? wrapped : 0.f;
+  };
+
+  for ( std::size_t i {}; i < current.length(); ++i )
+  {
+    const auto& from = previous[i];
+    const auto& to = current[i];
+
+    if ( boundary == BoundaryMode::Bounded )
+    {
+      output[i] = from + (to - from) * alpha;
+      continue;
+    }
+
+    const Vector3 offset
+    {
+      shortest(to.x - from.x),
+      shortest(to.y - from.y),
+      shortest(to.z - from.z),
+    };
+
+    const auto position = from + offset * alpha;
+
+    output[i] =
+    {
+      wrap(position.x),
+      wrap(position.y),
+      wrap(position.z),
+    };
+  }
+}
+
+
+int
+runRealtime(
+  const SimulationConfig& simulationConfig,
+  const RealtimeConfig& config )
+{
+  using Clock = std::chrono::steady_clock;
+
+  if ( config.fixedStep <= 0.0 ||
+       config.frameBudget <= 0.0 ||
+       config.maxSubsteps == 0 )
+  {
+    std::cout << "real-time frames need a fixed step, a budget and a substep\n";
+    return 2;
+  }
+
+  const auto boidCount = simulationConfig.boidCount;
+
+  AllocatorArena allocator {};
+
+  if ( allocator.reserve(
+        sizeof(Vector3) * boidCount * 2 +
+        sizeof(std::size_t) * 4 ) == false )
+  {
+    std::cout << "out of memory\n";
+    return 2;
+  }
+
+  Simulation simulation {};
+
+  if ( simulation.init(simulationConfig) == false )
+  {
+    allocator.free();
+
+    std::cout << "invalid simulation config or out of memory\n";
+    return 2;
+  }
+
+  QualityGovernor governor {};
+  governor.frameBudget = config.frameBudget * 1'000'000.0;
+  governor.init(
+    simulationConfig, config.maxSubsteps, config.maxLodIntervalShift );
+
+  simulation.setQuality(governor.quality().simulation);
+
+  std::size_t stepCount {};
+  std::size_t missedCount {};
+  std::size_t levelChangeCount {};
+  std::size_t lowestLevel {};
+
+  double maxFrameWork {};
+  double totalFrameWork {};
+
+  Vector3 presentedCentroid {};
+
+  {
+    Array <Vector3> previous {allocator, boidCount};
+    Array <Vector3> presented {allocator, boidCount};
+
+    std::copy_n(
+      simulation.positions().data(), boidCount, previous.data() );
+
+    FixedTimestep timestep {config.fixedStep};
+
+    const auto frameBudget =
+      std::chrono::duration_cast <Clock::duration> (
+        double_s{config.frameBudget} );
+
+//    the first frame runs a single step
+    auto lastFrameBegin = Clock::now() -
+      std::chrono::duration_cast <Clock::duration> (
+        double_s{config.fixedStep} );
+
+    for ( std::size_t frame {}; frame < config.frameCount; ++frame )
+    {
+      const auto frameBegin = Clock::now();
+
+      const auto steps = timestep.advance(
+        double_s{frameBegin - lastFrameBegin}.count(),
+        governor.quality().maxSubsteps );
+
+      lastFrameBegin = frameBegin;
+
+      double frameWork {};
+
+      for ( std::size_t i {}; i < steps; ++i )
+      {
+//        frames present the way between the last two steps
+        if ( i + 1 == steps )
+          std::copy_n(
+            simulation.positions().data(), boidCount, previous.data() );
+
+        simulation.step(config.stepDelta);
+
+        frameWork += double_us{
+          simulation.timeCounter[Simulation::PerfMarker::Total].last}.count();
+      }
+
+      stepCount += steps;
+
+      const auto presentBegin = Clock::now();
+
+      interpolatePositions(
+        previous, simulation.positions(),
+        timestep.alpha(), simulationConfig.boundary,
+        presented.data() );
+
+      const auto frameEnd = Clock::now();
+
+      frameWork += double_us{frameEnd - presentBegin}.count();
+
+      if ( frameEnd - frameBegin > frameBudget )
+        ++missedCount;
+
+      maxFrameWork = std::max(maxFrameWork, frameWork);
+      totalFrameWork += frameWork;
+
+      if ( governor.addFrame(frameWork) == true )
+      {
+        simulation.setQuality(governor.quality().simulation);
+
+        ++levelChangeCount;
+        lowestLevel = std::max(lowestLevel, governor.level);
+      }
+
+      if ( config.paceFrames == true )
+        std::this_thread::sleep_until(frameBegin + frameBudget);
+    }
+
+    simulation.drain();
+
+    for ( std::size_t i {}; i < boidCount; ++i )
+      presentedCentroid += presented[i];
+
+    presentedCentroid /= boidCount;
+
+    std::cout <<
+      "presented " << config.frameCount << " frames, " <<
+      stepCount << " steps, " <<
+      timestep.droppedTime << " s dropped\n";
+
+    std::cout <<
+      "frame work mean " << totalFrameWork / config.frameCount <<
+      " us, max " << maxFrameWork <<
+      " us, budget " << governor.frameBudget << " us\n";
+
+    const auto& quality = governor.quality();
+
+    std::cout <<
+      "quality level " << governor.level << " of " << governor.levelCount <<
+      " (stencil " << quality.simulation.stencilRadius <<
+      ", lod shift " << quality.simulation.lodIntervalShift <<
+      ", substeps " << quality.maxSubsteps << ")" <<
+      ", lowest " << lowestLevel <<
+      ", " << levelChangeCount << " changes\n";
+
+    std::cout <<
+      "presented centroid " << presentedCentroid.x << ", " <<
+      presentedCentroid.y << ", " << presentedCentroid.z << "\n";
+
+    std::cout << missedCount << " missed deadlines\n";
+  }
+
+  simulation.deinit();
+  allocator.free();
+
+  return missedCount > 0 ? 1 : 0;
+}
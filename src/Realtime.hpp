@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "Containers.hpp"
+#include "Vector.hpp"
+
+#include <cstddef>
+
+
+//  Turns wall time into fixed steps. advance() adds a frame's time and
+//  returns the steps due, at most maxSteps, whole steps beyond those are
+//  dropped. alpha() is how far the time left over reaches into the next
+//  step, presenting the flock that far between its last two states
+//  makes the motion smooth at any frame rate
+struct FixedTimestep
+{
+//  seconds
+  double step {};
+  double accumulator {};
+  double droppedTime {};
+
+
+  std::size_t advance(
+    const double frameTime,
+    const std::size_t maxSteps );
+
+  float alpha() const;
+};
+
+//  positions alpha of the way from previous to current,
+//  periodic flocks move along the shortest way around the cube
+void interpolatePositions(
+  const ArrayView <Vector3>& previous,
+  const ArrayView <Vector3>& current,
+  const float alpha,
+  const BoundaryMode,
+  Vector3* output );
+
+
+struct RealtimeConfig
+{
+//  the wall time a fixed step stands for, and the delta it steps with
+  double fixedStep {1.0 / 120.0};
+  float stepDelta {1.f / 240.f};
+
+//  presented frames and the wall time each may take, in seconds
+  std::size_t frameCount {600};
+  double frameBudget {1.0 / 60.0};
+
+//  fixed steps a frame may run at full quality,
+//  the governor lowers it as its last resort
+  std::size_t maxSubsteps {4};
+  std::size_t maxLodIntervalShift {2};
+
+//  sleeps out what is left of each frame's budget like a vsynced
+//  presenter, otherwise frames run back to back
+  bool paceFrames {true};
+};
+
+//  Presents frameCount frames of the config's flock in real time: each
+//  frame runs the fixed steps its wall time is due, interpolates the
+//  presented positions and reports the steps' Total marker plus the
+//  interpolation to a QualityGovernor. Prints a summary and returns the
+//  process exit code: 0 if every frame met its deadline, 1 if some
+//  didn't, 2 for an invalid config or missing memory
+int runRealtime(
+  const SimulationConfig&,
+  const RealtimeConfig& );
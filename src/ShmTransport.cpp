@@ -0,0 +1,280 @@
+#include "ShmTransport.hpp"
+
+#include <new>
+#include <atomic>
+#include <thread>
+#include <cassert>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+//  atomics are shared between address spaces,
+//  which only works if they don't fall back to locks
+static_assert(std::atomic_size_t::is_always_lock_free);
+
+struct ShmTransport::Header
+{
+  alignas(64) std::atomic_size_t arrived {};
+  alignas(64) std::atomic_size_t generation {};
+
+  std::size_t rankCount {};
+  std::size_t messageCapacity {};
+};
+
+namespace
+{
+
+constexpr std::size_t CacheLineSize {64};
+
+std::size_t
+alignToCacheLine(
+  const std::size_t bytes )
+{
+  return (bytes + CacheLineSize - 1) / CacheLineSize * CacheLineSize;
+}
+
+//  a mailbox starts with its message size, the payload follows
+//  on the next cache line
+std::size_t
+mailboxStride(
+  const std::size_t messageCapacity )
+{
+  return CacheLineSize + alignToCacheLine(messageCapacity);
+}
+
+} // namespace
+
+
+ShmTransport::~ShmTransport()
+{
+  close();
+}
+
+ShmTransport::Header&
+ShmTransport::header() const
+{
+  return *static_cast <Header*> (mRegion);
+}
+
+std::byte*
+ShmTransport::mailbox(
+  const std::size_t round,
+  const std::size_t from,
+  const std::size_t to ) const
+{
+  const auto index =
+    (round % 2 * mRankCount + from) * mRankCount + to;
+
+  return
+    static_cast <std::byte*> (mRegion) +
+    alignToCacheLine(sizeof(Header)) +
+    index * mMailboxStride;
+}
+
+bool
+ShmTransport::map(
+  const int fd,
+  const std::size_t size )
+{
+  const auto region = mmap(
+    nullptr, size,
+    PROT_READ | PROT_WRITE, MAP_SHARED,
+    fd, 0 );
+
+  ::close(fd);
+
+  if ( region == MAP_FAILED )
+    return false;
+
+  mRegion = region;
+  mRegionSize = size;
+
+  return true;
+}
+
+bool
+ShmTransport::create(
+  const char* name,
+  const std::size_t rankCount,
+  const std::size_t messageCapacity )
+{
+  assert(mRegion == nullptr);
+  assert(rankCount > 0);
+
+//  a crashed run may have left its segment behind
+  shm_unlink(name);
+
+  const auto fd = shm_open(
+    name, O_CREAT | O_EXCL | O_RDWR, 0600 );
+
+  if ( fd < 0 )
+    return false;
+
+  const auto size = regionSize(rankCount, messageCapacity);
+
+  if ( ftruncate(fd, size) != 0 )
+  {
+    ::close(fd);
+    return false;
+  }
+
+  if ( map(fd, size) == false )
+    return false;
+
+  auto header = new (mRegion) Header{};
+  header->rankCount = rankCount;
+  header->messageCapacity = messageCapacity;
+
+  mRankCount = rankCount;
+  mMessageCapacity = messageCapacity;
+  mMailboxStride = mailboxStride(messageCapacity);
+
+  return true;
+}
+
+bool
+ShmTransport::open(
+  const char* name,
+  const std::size_t rank )
+{
+  assert(mRegion == nullptr);
+
+  const auto fd = shm_open(name, O_RDWR, 0600);
+
+  if ( fd < 0 )
+    return false;
+
+  struct stat info {};
+
+  if ( fstat(fd, &info) != 0 )
+  {
+    ::close(fd);
+    return false;
+  }
+
+  if ( map(fd, info.st_size) == false )
+    return false;
+
+  mRankCount = header().rankCount;
+  mMessageCapacity = header().messageCapacity;
+  mMailboxStride = mailboxStride(mMessageCapacity);
+
+  assert(rank < mRankCount);
+  assert(regionSize(mRankCount, mMessageCapacity) == mRegionSize);
+
+  mRank = rank;
+  mRound = {};
+
+  return true;
+}
+
+void
+ShmTransport::close()
+{
+  if ( mRegion == nullptr )
+    return;
+
+  munmap(mRegion, mRegionSize);
+
+  mRegion = {};
+  mRegionSize = {};
+}
+
+void
+ShmTransport::unlink(
+  const char* name )
+{
+  shm_unlink(name);
+}
+
+std::size_t
+ShmTransport::rank() const
+{
+  return mRank;
+}
+
+std::size_t
+ShmTransport::rankCount() const
+{
+  return mRankCount;
+}
+
+std::size_t
+ShmTransport::messageCapacity() const
+{
+  return mMessageCapacity;
+}
+
+bool
+ShmTransport::send(
+  const std::size_t peer,
+  const void* data,
+  const std::size_t bytes )
+{
+  assert(peer < mRankCount);
+
+  if ( bytes > mMessageCapacity )
+    return false;
+
+  const auto box = mailbox(mRound, mRank, peer);
+
+  std::memcpy(box, &bytes, sizeof(bytes));
+
+  if ( bytes > 0 )
+    std::memcpy(box + CacheLineSize, data, bytes);
+
+  return true;
+}
+
+const void*
+ShmTransport::receive(
+  const std::size_t peer,
+  std::size_t& bytes )
+{
+  assert(peer < mRankCount);
+  assert(mRound > 0);
+
+//  messages were sent before the last barrier
+  const auto box = mailbox(mRound - 1, peer, mRank);
+
+  std::memcpy(&bytes, box, sizeof(bytes));
+
+  return box + CacheLineSize;
+}
+
+void
+ShmTransport::barrier()
+{
+  auto& header = this->header();
+
+  const auto generation =
+    header.generation.load(std::memory_order_acquire);
+
+  if ( header.arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == mRankCount )
+  {
+    header.arrived.store(0, std::memory_order_relaxed);
+    header.generation.fetch_add(1, std::memory_order_release);
+  }
+  else
+  {
+//    ranks may outnumber cores, so give the slot away while waiting
+    while ( header.generation.load(std::memory_order_acquire) == generation )
+      std::this_thread::yield();
+  }
+
+  ++mRound;
+}
+
+std::size_t
+ShmTransport::regionSize(
+  const std::size_t rankCount,
+  const std::size_t messageCapacity )
+{
+  return
+    alignToCacheLine(sizeof(Header)) +
+    2 * rankCount * rankCount * mailboxStride(messageCapacity);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Transport.hpp"
+
+#include <cstddef>
+
+
+//  Transport between processes on one host through a POSIX shared memory
+//  segment. The segment holds a barrier and one mailbox per ordered rank
+//  pair and round parity, so a rank can fill next round's mailboxes
+//  while slower peers still read the current ones
+class ShmTransport final : public Transport
+{
+  struct Header;
+
+  void* mRegion {};
+  std::size_t mRegionSize {};
+
+  std::size_t mRank {};
+  std::size_t mRankCount {};
+  std::size_t mMessageCapacity {};
+  std::size_t mMailboxStride {};
+
+  std::size_t mRound {};
+
+
+  Header& header() const;
+
+  std::byte* mailbox(
+    const std::size_t round,
+    const std::size_t from,
+    const std::size_t to ) const;
+
+  bool map(
+    const int fd,
+    const std::size_t size );
+
+
+public:
+  ShmTransport() = default;
+  ShmTransport( const ShmTransport& ) = delete;
+  ~ShmTransport() override;
+
+
+//  creates and maps the named segment, ranks open() it afterwards
+  bool create(
+    const char* name,
+    const std::size_t rankCount,
+    const std::size_t messageCapacity );
+
+  bool open(
+    const char* name,
+    const std::size_t rank );
+
+  void close();
+
+  static void unlink( const char* name );
+
+
+  std::size_t rank() const override;
+  std::size_t rankCount() const override;
+  std::size_t messageCapacity() const override;
+
+  bool send(
+    const std::size_t peer,
+    const void* data,
+    const std::size_t bytes ) override;
+
+  const void* receive(
+    const std::size_t peer,
+    std::size_t& bytes ) override;
+
+  void barrier() override;
+
+
+  static std::size_t regionSize(
+    const std::size_t rankCount,
+    const std::size_t messageCapacity );
+};
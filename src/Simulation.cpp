@@ -0,0 +1,905 @@
+#include "Simulation.hpp"
+#include "BoidRules.hpp"
+#include "Obstacles.hpp"
+#include "FlowField.hpp"
+#include "GridTuner.hpp"
+#include "Octree.hpp"
+#include "LodScheduler.hpp"
+#include "IncrementalBinning.hpp"
+#include "FramePipeline.hpp"
+#include "FramePublisher.hpp"
+#include "Vector.hpp"
+
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <new>
+
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+
+
+namespace
+{
+using Clock = std::chrono::high_resolution_clock;
+
+
+std::size_t
+hashCoordinate(
+  const Vector3::value_type coordinate,
+  const std::size_t cellCount,
+  const BoundaryMode boundary )
+{
+  const auto cell =
+    static_cast <std::size_t> (coordinate * cellCount);
+
+  if ( cell < cellCount )
+    return cell;
+
+//  coordinate == 1 sits on the far wall
+//  or on the near one after wrapping
+  return boundary == BoundaryMode::Periodic
+    ? 0
+    : cellCount - 1;
+}
+
+std::size_t
+hashPos(
+  const Vector3& pos,
+  const std::size_t cellCount,
+  const BoundaryMode boundary )
+{
+  return
+    hashCoordinate(pos.x, cellCount, boundary) +
+    hashCoordinate(pos.y, cellCount, boundary) * cellCount +
+    hashCoordinate(pos.z, cellCount, boundary) * cellCount * cellCount;
+}
+
+
+std::size_t
+boidMemoryRequirement()
+{
+  return
+    sizeof(Vector3) +
+    sizeof(Vector3) +
+    sizeof(std::uint32_t) +
+    sizeof(Vector3) +
+    sizeof(Vector3) +
+    sizeof(Vector3) +
+    sizeof(Vector3) +
+    sizeof(GroupId) +
+    sizeof(SpeciesId);
+}
+
+std::size_t
+gridCellCountOf(
+  const SimulationConfig& config )
+{
+  if ( config.spatialIndex != SpatialIndex::Grid )
+    return 0;
+
+  const auto axisCount = config.maxCellPerAxisCount();
+
+  return axisCount * axisCount * axisCount;
+}
+
+//  a cell holds at most one group per species
+//  and no group is empty after a full rebuild
+std::size_t
+groupCapacityOf(
+  const SimulationConfig& config )
+{
+  if ( config.spatialIndex != SpatialIndex::Grid )
+    return config.boidCount;
+
+  return std::min(
+    config.boidCount,
+    gridCellCountOf(config) * config.speciesCount );
+}
+
+SimulationFeatures
+featuresOf(
+  const SimulationConfig& config,
+  const SpeciesTable& species,
+  const ObstacleScene& obstacles )
+{
+  SimulationFeatures features {};
+
+  for ( SpeciesId s {}; s < species.count(); ++s )
+  {
+    const auto& weights = species.rulesets[s].weights;
+
+    if ( weights.alignment != 0.f )
+      features |= AlignmentRule;
+
+    if ( weights.coherence != 0.f )
+      features |= CoherenceRule;
+
+    if ( weights.separation != 0.f )
+      features |= SeparationRule;
+  }
+
+//  species interactions are applied with the coherence rule
+  if ( config.spatialIndex == SpatialIndex::Grid &&
+       species.hasInteractions() == true )
+    features |= CoherenceRule;
+
+  if ( config.boundary == BoundaryMode::Periodic )
+    features |= PeriodicBoundary;
+
+  if ( obstacles.empty() == false )
+    features |= ObstacleAvoidance;
+
+  if ( config.normalization == NormalizeMode::Approximate )
+    features |= ApproximateNormalize;
+
+  return features;
+}
+}
+
+
+bool
+SimulationConfig::isValid() const
+{
+  if ( boidCount == 0 || speciesCount == 0 || frameCount == 0 )
+    return false;
+
+  if ( (speciesRulesets.length() != 0 &&
+        speciesRulesets.length() != speciesCount) ||
+       (speciesInteractions.length() != 0 &&
+        speciesInteractions.length() != speciesCount * speciesCount) )
+    return false;
+
+//  without workers the steps run on the caller,
+//  but exports need a thread of their own
+  if ( threadCount == 0 && pipelineDepth > 0 )
+    return false;
+
+//  boids, cells and groups are indexed with 32 bits
+  if ( boidCount >= NoGroup ||
+       gridCellCountOf(*this) >= NoGroup )
+    return false;
+
+//  the octree has no uniform grid to stencil or tune
+  if ( spatialIndex != SpatialIndex::Grid &&
+       (stencilRadius != 0 || adaptiveGrid == true) )
+    return false;
+
+  if ( incrementalBinning == true &&
+       (spatialIndex != SpatialIndex::Grid ||
+        adaptiveGrid == true ||
+        fullRebinInterval == 0) )
+    return false;
+
+  return spatialIndex != SpatialIndex::Grid || cellPerAxisCount > 0;
+}
+
+bool
+SimulationConfig::transformHashesCells() const
+{
+  return
+    incrementalBinning == true ||
+    (pipelineDepth > 0 &&
+     spatialIndex == SpatialIndex::Grid &&
+     adaptiveGrid == false);
+}
+
+std::size_t
+SimulationConfig::maxCellPerAxisCount() const
+{
+  return adaptiveGrid
+    ? std::max(cellPerAxisCount, GridTuner{}.maxCellsPerAxis)
+    : cellPerAxisCount;
+}
+
+
+//  members are released in reverse, which keeps the arena LIFO,
+//  so the thread pool allocating its threads on init() comes last
+struct Simulation::State
+{
+  BoidData boids {};
+
+//  head of each cell's group list
+  Array <GroupId> cells {};
+  GroupTable groups {};
+
+  SpeciesTable species {};
+  ObstacleScene obstacles {};
+  MortonOctree octree {};
+  IncrementalBinning binning {};
+  LodScheduler lod {};
+
+  FramePipeline pipeline {};
+  FramePublisher publisher {};
+
+  FlowField flowField {};
+
+  GridTuner gridTuner {};
+  std::size_t gridCellsPerAxis {};
+
+  ThreadPool threadPool {};
+
+
+  State(
+    AllocatorArena&,
+    const SimulationConfig& );
+
+  ~State();
+
+
+  void buildObstacles( const ArrayView <Obstacle>& );
+  void addFlowSources( const ArrayView <FlowSource>& );
+  void spawnBoids(
+    const BoundaryMode,
+    const std::uint32_t seed );
+};
+
+Simulation::State::State(
+  AllocatorArena& allocator,
+  const SimulationConfig& config )
+  : boids
+    {
+      {allocator, config.boidCount},
+      {allocator, config.boidCount},
+      {allocator, config.boidCount},
+      {allocator, config.boidCount},
+      {allocator, config.boidCount},
+      {allocator, config.boidCount},
+      {allocator, config.boidCount},
+      {allocator, config.boidCount},
+      {allocator, config.boidCount},
+    }
+  , cells{allocator, gridCellCountOf(config)}
+  , groups{allocator, groupCapacityOf(config), config.stencilRadius > 0}
+  , species{allocator, config.speciesCount, config.boidCount}
+  , obstacles{allocator, config.obstacles.length()}
+  , octree{allocator,
+      config.spatialIndex == SpatialIndex::Octree ? config.boidCount : 0}
+  , binning{allocator,
+      config.incrementalBinning ? config.boidCount : 0, groupCapacityOf(config)}
+  , lod{allocator, config.temporalLod ? config.boidCount : 0}
+  , pipeline{allocator,
+      config.boidCount, config.pipelineDepth, config.frameCount}
+  , flowField{allocator, config.flowSources.length()}
+{
+  threadPool.waitSpinCount = config.waitSpinCount;
+  threadPool.idleSpinCount = config.idleSpinCount;
+  threadPool.init(
+    allocator, config.threadCount, 2 );
+
+
+  for ( SpeciesId s {}; s < species.count(); ++s )
+  {
+    species.rulesets[s] = config.speciesRulesets.length() > 0
+      ? config.speciesRulesets[s]
+      : config.ruleset;
+
+    std::fill(
+      boids.species.data() + species.boidsBegin(s),
+      boids.species.data() + species.boidsEnd(s),
+      s );
+  }
+
+  std::copy(
+    config.speciesInteractions.begin(),
+    config.speciesInteractions.end(),
+    species.interactions.data() );
+
+  buildObstacles(config.obstacles);
+
+
+  if ( config.publishFrames == true &&
+       publisher.create(FrameRing::DefaultName, config.boidCount, config.publishedSlotCount) == false )
+    std::cout << "failed to create frame ring " << FrameRing::DefaultName << "\n";
+
+  if ( publisher.enabled() == true )
+    pipeline.publisher = &publisher;
+
+
+  addFlowSources(config.flowSources);
+
+  spawnBoids(config.boundary, config.seed);
+
+
+  gridTuner.init(config.cellPerAxisCount);
+
+  gridCellsPerAxis = config.adaptiveGrid
+    ? gridTuner.cellsPerAxis
+    : config.cellPerAxisCount;
+}
+
+Simulation::State::~State()
+{
+  if ( pipeline.enabled() == true )
+    pipeline.drain(threadPool);
+
+  publisher.close();
+
+  threadPool.deinit();
+}
+
+void
+Simulation::State::buildObstacles(
+  const ArrayView <Obstacle>& sceneObstacles )
+{
+  std::copy(
+    sceneObstacles.begin(),
+    sceneObstacles.end(),
+    obstacles.obstacles.data() );
+
+  float influenceDistance {};
+
+  for ( SpeciesId s {}; s < species.count(); ++s )
+    influenceDistance = std::max(
+      influenceDistance,
+      species.rulesets[s].obstacleAvoidanceDistance );
+
+  obstacles.build(influenceDistance);
+}
+
+void
+Simulation::State::addFlowSources(
+  const ArrayView <FlowSource>& sources )
+{
+//  the field is sized for all of them, so none is dropped
+  for ( const auto& source : sources )
+    flowField.addSource(source);
+
+  flowField.bakeStatic();
+}
+
+void
+Simulation::State::spawnBoids(
+  const BoundaryMode boundary,
+  const std::uint32_t seed )
+{
+  std::random_device rd {};
+  std::uniform_real_distribution dist(0.f, 1.f);
+  std::minstd_rand0 engine {seed != 0 ? seed : rd()};
+
+//  drawn in index order from one engine, so a seed reproduces the flock
+  for ( std::size_t i {}; i < boids.position.length(); ++i )
+  {
+    boids.position[i] = { dist(engine), dist(engine), dist(engine) };
+//    boids.velocity[i] = { dist(engine), dist(engine), dist(engine) };
+
+//    without walls nothing would set a resting flock in motion
+    if ( boundary == BoundaryMode::Periodic )
+      boids.velocity[i] = Vector3
+      {
+        dist(engine) - 0.5f,
+        dist(engine) - 0.5f,
+        dist(engine) - 0.5f,
+      }.normalized();
+  }
+}
+
+
+Simulation::~Simulation()
+{
+  deinit();
+}
+
+bool
+Simulation::init(
+  const SimulationConfig& config,
+  AllocatorArena* parent )
+{
+  assert(mState == nullptr);
+
+  if ( config.isValid() == false )
+    return false;
+
+  if ( mAllocator.reserve(memoryRequirement(config), parent) == false )
+    return false;
+
+  mParentAllocator = parent;
+  mConfig = config;
+  mQuality = {config.stencilRadius, 0};
+  mFrame = {};
+
+  for ( std::size_t i {}; i < PerfMarker::Count; ++i )
+  {
+    timeCounter[i] = {};
+    cycleCounter[i] = {};
+  }
+
+  mState = mAllocator.allocate <State> (1, alignof(State));
+
+  assert(mState != nullptr);
+  new (mState) State{mAllocator, mConfig};
+
+//  a host asking for published frames relies on readers seeing them
+  if ( mConfig.publishFrames == true &&
+       mState->publisher.enabled() == false )
+  {
+    deinit();
+    return false;
+  }
+
+  mFeatures = featuresOf(mConfig, mState->species, mState->obstacles);
+  mIsa = std::min(selectCpuIsa(), mConfig.maxIsa);
+  mStepFunction = stepFunction(mIsa, mFeatures);
+
+  return true;
+}
+
+void
+Simulation::drain()
+{
+  assert(mState != nullptr);
+
+  if ( mState->pipeline.enabled() == true )
+    mState->pipeline.drain(mState->threadPool);
+}
+
+void
+Simulation::deinit()
+{
+  if ( mState == nullptr )
+    return;
+
+  mState->~State();
+  mAllocator.deallocate(mState, 1);
+  mState = {};
+
+  mQuality = {};
+  mFeatures = {};
+  mIsa = {};
+  mStepFunction = {};
+
+  mAllocator.free(mParentAllocator);
+  mParentAllocator = {};
+}
+
+bool
+Simulation::initialized() const
+{
+  return mState != nullptr;
+}
+
+const SimulationConfig&
+Simulation::config() const
+{
+  return mConfig;
+}
+
+SimulationQuality
+Simulation::quality() const
+{
+  return mQuality;
+}
+
+bool
+Simulation::setQuality(
+  const SimulationQuality& quality )
+{
+  assert(mState != nullptr);
+
+  if ( quality.stencilRadius > mConfig.stencilRadius )
+    return false;
+
+  if ( quality.lodIntervalShift > 0 &&
+       (mConfig.temporalLod == false ||
+        quality.lodIntervalShift > LodScheduler::MaxIntervalShift) )
+    return false;
+
+  mQuality = quality;
+  mState->lod.intervalShift = quality.lodIntervalShift;
+
+  return true;
+}
+
+bool
+Simulation::setFlowSource(
+  const std::size_t id,
+  const FlowSource& source )
+{
+  assert(mState != nullptr);
+
+  auto& flowField = mState->flowField;
+
+  if ( id >= flowField.sourceCount ||
+       flowField.sources[id].isStatic == true ||
+       source.isStatic == true )
+    return false;
+
+  flowField.sources[id] = source;
+
+  return true;
+}
+
+SimulationFeatures
+Simulation::features() const
+{
+  return mFeatures;
+}
+
+CpuIsa
+Simulation::isa() const
+{
+  return mIsa;
+}
+
+std::size_t
+Simulation::frame() const
+{
+  return mFrame;
+}
+
+std::size_t
+Simulation::boidCount() const
+{
+  return mConfig.boidCount;
+}
+
+std::size_t
+Simulation::gridCellsPerAxis() const
+{
+  assert(mState != nullptr);
+
+  return mState->gridCellsPerAxis;
+}
+
+ArrayView <Vector3>
+Simulation::positions() const
+{
+  assert(mState != nullptr);
+
+  return mState->boids.position;
+}
+
+ArrayView <Vector3>
+Simulation::velocities() const
+{
+  assert(mState != nullptr);
+
+  return mState->boids.velocity;
+}
+
+ArrayView <SpeciesId>
+Simulation::species() const
+{
+  assert(mState != nullptr);
+
+  return mState->boids.species;
+}
+
+ArrayView <FrameSummary>
+Simulation::records() const
+{
+  assert(mState != nullptr);
+
+  return mState->pipeline.records;
+}
+
+const MortonOctree&
+Simulation::octree() const
+{
+  assert(mState != nullptr);
+
+  return mState->octree;
+}
+
+void
+Simulation::stepN(
+  const std::size_t count,
+  const float delta )
+{
+  for ( std::size_t i {}; i < count; ++i )
+    step(delta);
+}
+
+void
+Simulation::step(
+  const float delta )
+{
+  assert(mState != nullptr);
+  assert(mStepFunction != nullptr);
+
+  (this->*mStepFunction)(delta);
+}
+
+//  The target pragmas apply to the member templates and their lambdas,
+//  inline helpers they call are inlined into each variant. Functions
+//  shared between variants are compiled for the baseline only, so no
+//  wider instruction leaks into code every CPU runs
+template <>
+struct SimulationKernels <CpuIsa::Baseline>
+{
+#include "SimulationKernels.inl"
+};
+
+#if defined(KERNEL_MULTIVERSIONING)
+
+#pragma GCC push_options
+#pragma GCC target("sse4.2,popcnt")
+
+template <>
+struct SimulationKernels <CpuIsa::Sse42>
+{
+#include "SimulationKernels.inl"
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma,bmi2")
+
+template <>
+struct SimulationKernels <CpuIsa::Avx2>
+{
+#include "SimulationKernels.inl"
+};
+
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512vl,avx512dq,avx512bw,avx2,fma,bmi2")
+
+template <>
+struct SimulationKernels <CpuIsa::Avx512>
+{
+#include "SimulationKernels.inl"
+};
+
+#pragma GCC pop_options
+
+#endif
+
+template <CpuIsa Isa, SimulationFeatures Features>
+void
+Simulation::stepWith(
+  const float delta )
+{
+  constexpr auto boundary = (Features & PeriodicBoundary) != 0
+    ? BoundaryMode::Periodic
+    : BoundaryMode::Bounded;
+
+  using Kernels = SimulationKernels <Isa>;
+
+  const auto frameBegin = Clock::now();
+
+  const bool fullRebin =
+    mConfig.incrementalBinning == false ||
+    mFrame % mConfig.fullRebinInterval == 0;
+
+  PERF_TIME_BEGIN(PerfMarker::Total);
+  PERF_TIME_BEGIN_COPY(PerfMarker::ResetTask, PerfMarker::Total);
+
+  if ( fullRebin == true )
+    resetGroups();
+
+  PERF_TIME_END(PerfMarker::ResetTask);
+  PERF_TIME_BEGIN(PerfMarker::HashPosTask);
+
+  if ( fullRebin == true )
+    Kernels::template binBoids <boundary> (*this);
+
+  PERF_TIME_END(PerfMarker::HashPosTask);
+  PERF_TIME_BEGIN(PerfMarker::Summing);
+
+  if ( fullRebin == true )
+    Kernels::sumGroups(*this);
+
+  PERF_TIME_END(PerfMarker::Summing);
+  PERF_TIME_BEGIN(PerfMarker::NeighborStencil);
+
+  if ( mQuality.stencilRadius > 0 )
+    Kernels::template gatherStencil <boundary> (*this);
+
+  PERF_TIME_END(PerfMarker::NeighborStencil);
+  PERF_TIME_BEGIN(PerfMarker::RulesCalc);
+
+  updateFlowField();
+
+  if constexpr ( (Features & ObstacleAvoidance) != 0 )
+    queryObstacles <boundary> ();
+
+  PERF_TIME_END(PerfMarker::RulesCalc);
+  PERF_TIME_BEGIN(PerfMarker::Transform);
+
+//  the previous frame's export may still be copying positions
+  if ( mState->pipeline.enabled() == true )
+    mState->pipeline.waitForCapture(mState->threadPool);
+
+  Kernels::template steerBoids <Features> (*this, delta);
+
+  PERF_TIME_END(PerfMarker::Transform);
+  PERF_TIME_BEGIN(PerfMarker::Rebin);
+
+//  groups for the next frame, unless it rebuilds them anyway
+  if ( mConfig.incrementalBinning == true &&
+       (mFrame + 1) % mConfig.fullRebinInterval != 0 )
+    rebinBoids();
+
+  PERF_TIME_END(PerfMarker::Rebin);
+  PERF_TIME_BEGIN(PerfMarker::Export);
+
+  exportFrame();
+
+  PERF_TIME_END(PerfMarker::Export);
+  PERF_TIME_END(PerfMarker::Total);
+
+  if ( mConfig.adaptiveGrid == true )
+    tuneGrid(
+      std::chrono::duration_cast <double_us> (
+        Clock::now() - frameBegin).count() );
+
+  for ( size_t i {}; i < PerfMarker::Count; ++i )
+    timeCounter[i].update(mConfig.frameCount);
+
+  ++mFrame;
+}
+
+void
+Simulation::resetGroups()
+{
+  auto& cells = mState->cells;
+
+  const auto gridCellsPerAxis = mState->gridCellsPerAxis;
+
+  const std::size_t gridCellCount =
+    gridCellsPerAxis * gridCellsPerAxis * gridCellsPerAxis;
+
+//  binning zeroes each group as it creates it
+  mState->groups.count = {};
+
+  if ( mConfig.spatialIndex == SpatialIndex::Grid )
+    std::fill_n(cells.data(), gridCellCount, NoGroup);
+}
+
+void
+Simulation::updateFlowField()
+{
+  PERF_TIME_BEGIN(PerfMarker::FlowFieldTask);
+
+  mState->flowField.update();
+
+  PERF_TIME_END(PerfMarker::FlowFieldTask);
+}
+
+template <BoundaryMode boundary>
+void
+Simulation::queryObstacles()
+{
+  PERF_TIME_BEGIN(PerfMarker::ObstacleAvoidanceTask);
+
+  auto& boids = mState->boids;
+  auto& species = mState->species;
+  auto& obstacles = mState->obstacles;
+
+  const auto obstacleAvoidanceTask =
+  [&boids, &species, &obstacles] ( const std::size_t rangeStart, const std::size_t rangeEnd )
+  {
+    for ( SpeciesId s {}; s < species.count(); ++s )
+    {
+      const auto avoidanceDistance =
+        species.rulesets[s].obstacleAvoidanceDistance;
+
+      const auto begin = std::max(rangeStart, species.boidsBegin(s));
+      const auto end = std::min(rangeEnd, species.boidsEnd(s));
+
+      for ( std::size_t i = begin; i < end; ++i )
+        boids.obstacleAvoidance[i] =
+          wallAvoidance <boundary> (boids.position[i], avoidanceDistance);
+
+      obstacles.queryAvoidance(
+        boids.position.data(),
+        boids.obstacleAvoidance.data(),
+        begin, std::max(begin, end),
+        avoidanceDistance );
+    }
+  };
+
+  mState->threadPool.parallel_for(
+    obstacleAvoidanceTask, mConfig.boidCount,
+    mConfig.loopSchedule, mConfig.loopGrainSize );
+
+  PERF_TIME_END(PerfMarker::ObstacleAvoidanceTask);
+}
+
+void
+Simulation::rebinBoids()
+{
+  auto& boids = mState->boids;
+  auto& groups = mState->groups;
+  auto& binning = mState->binning;
+
+  binning.moveBoids(boids, groups, mState->cells);
+
+//  position and velocity share the group's cache line,
+//  so one pass updates both
+  binning.updateGroups(boids, groups, 0, mConfig.boidCount);
+}
+
+void
+Simulation::exportFrame()
+{
+  auto& boids = mState->boids;
+  auto& pipeline = mState->pipeline;
+  auto& publisher = mState->publisher;
+
+//  overlaps the next frame up to its transform pass
+  if ( pipeline.enabled() == true )
+    pipeline.submit(mState->threadPool, boids, mFrame);
+
+  else if ( publisher.enabled() == true )
+    publisher.publish(
+      mFrame, boids.position.data(), boids.velocity.data() );
+}
+
+void
+Simulation::tuneGrid(
+  const double frameTime )
+{
+  auto& gridTuner = mState->gridTuner;
+
+  gridTuner.addFrame(frameTime);
+
+//  cells still hold this frame's binning
+  if ( gridTuner.windowComplete() == true &&
+       gridTuner.retune(measureOccupancy(mState->groups, mState->cells, mConfig.boidCount)) == true )
+    mState->gridCellsPerAxis = gridTuner.cellsPerAxis;
+}
+
+//  entry I runs the features I % (AllFeatures + 1) with the kernels of
+//  instruction set I / (AllFeatures + 1)
+template <std::size_t... Variants>
+constexpr std::array <Simulation::StepFunction, sizeof...(Variants)>
+Simulation::makeStepTable(
+  std::index_sequence <Variants...> )
+{
+  return
+  {
+    &Simulation::stepWith <
+      static_cast <CpuIsa> (Variants / (AllFeatures + 1)),
+      static_cast <SimulationFeatures> (Variants % (AllFeatures + 1))>...
+  };
+}
+
+Simulation::StepFunction
+Simulation::stepFunction(
+  const CpuIsa isa,
+  const SimulationFeatures features )
+{
+  static constexpr auto table = makeStepTable(
+    std::make_index_sequence <CpuIsaCount * (AllFeatures + 1)> {} );
+
+  const auto variant =
+    static_cast <std::size_t> (isa) * (AllFeatures + 1) + features;
+
+  assert(features <= AllFeatures);
+  assert(variant < table.size());
+
+  return table[variant];
+}
+
+std::size_t
+Simulation::memoryRequirement(
+  const SimulationConfig& config )
+{
+  const auto boidCount = config.boidCount;
+
+  return
+    sizeof(State) + alignof(State) +
+    ThreadPool::memoryRequirement(config.threadCount) +
+    boidMemoryRequirement() * boidCount +
+    sizeof(GroupId) * gridCellCountOf(config) +
+    GroupTable::memoryRequirement(
+      groupCapacityOf(config), config.stencilRadius > 0 ) +
+    SpeciesTable::memoryRequirement(config.speciesCount) +
+    ObstacleScene::memoryRequirement(config.obstacles.length()) +
+    MortonOctree::memoryRequirement(
+      config.spatialIndex == SpatialIndex::Octree ? boidCount : 0 ) +
+    FlowField::memoryRequirement(config.flowSources.length()) +
+    LodScheduler::memoryRequirement(config.temporalLod ? boidCount : 0) +
+    IncrementalBinning::memoryRequirement(
+      config.incrementalBinning ? boidCount : 0, groupCapacityOf(config) ) +
+    FramePipeline::memoryRequirement(
+      boidCount, config.pipelineDepth, config.frameCount ) +
+    sizeof(std::size_t) * 20;
+}
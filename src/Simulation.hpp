@@ -0,0 +1,302 @@
+#pragma once
+
+#include "Allocators.hpp"
+#include "Boids.hpp"
+#include "Containers.hpp"
+#include "CpuFeatures.hpp"
+#include "ThreadPool.hpp"
+#include "FastMath.hpp"
+#include "PerformanceCounter.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+
+struct FrameSummary;
+struct MortonOctree;
+struct Obstacle;
+struct FlowSource;
+
+template <CpuIsa>
+struct SimulationKernels;
+
+
+struct SimulationConfig
+{
+//  workers besides the stepping thread, 0 steps on the caller alone
+  std::size_t threadCount {3};
+  std::size_t boidCount {400'000};
+
+//  how per-boid stages split their range between threads,
+//  non-static schedules claim chunks of at least loopGrainSize boids
+  ThreadPool::Schedule loopSchedule {ThreadPool::Schedule::Guided};
+  std::size_t loopGrainSize {2048};
+
+//  spin checks before a waiting thread blocks,
+//  0 saves CPU time, larger values lower wake-up latency
+  std::size_t waitSpinCount {1024};
+  std::size_t idleSpinCount {1024};
+
+  std::size_t cellPerAxisCount {100};
+
+//  retunes the resolution at runtime, starting from cellPerAxisCount
+  bool adaptiveGrid {false};
+
+//  cells gathered around a boid's own cell along each axis,
+//  0 reads only the own cell's aggregates
+  std::size_t stencilRadius {0};
+  BoundaryMode boundary {BoundaryMode::Bounded};
+
+//  the octree groups boids without a uniform grid, so it can't be
+//  stenciled or tuned, species interactions are only evaluated on the grid
+  SpatialIndex spatialIndex {SpatialIndex::Grid};
+
+//  keeps groups between frames and only moves boids that changed cell,
+//  a full rebuild every fullRebinInterval frames discards float drift.
+//  Needs a fixed uniform grid
+  bool incrementalBinning {false};
+  std::size_t fullRebinInterval {120};
+
+  std::size_t speciesCount {1};
+
+//  every species starts out with it, rules weighted 0
+//  by all species are compiled out of the step
+  BoidRuleset ruleset {};
+
+//  one ruleset per species in place of ruleset, or none
+  ArrayView <BoidRuleset> speciesRulesets {};
+
+//  speciesCount * speciesCount interactions laid out like
+//  SpeciesTable::interactions, or none. Both views are
+//  copied at init() and may be released after it
+  ArrayView <float> speciesInteractions {};
+
+//  scene the flock steers around and through, copied at init().
+//  Dynamic flow sources can be moved between steps, see setFlowSource()
+  ArrayView <Obstacle> obstacles {};
+  ArrayView <FlowSource> flowSources {};
+
+//  steers distant or stable boids at a reduced rate
+  bool temporalLod {false};
+
+//  how the steering pass normalizes rules and velocities
+  NormalizeMode normalization {DefaultNormalizeMode};
+
+//  highest instruction set the kernels may use, the host and
+//  BOIDS_ISA may lower it further, see selectCpuIsa()
+  CpuIsa maxIsa {CpuIsa::Avx512};
+
+//  spawns the same flock for the same seed, 0 draws a random one
+  std::uint32_t seed {0};
+
+//  frames perf counters average over, also the
+//  number of frames exports are recorded for
+  std::size_t frameCount {600};
+
+//  frames whose export may still run while the following ones simulate,
+//  0 disables exporting
+  std::size_t pipelineDepth {0};
+
+//  publishes every frame into a shared memory ring of publishedSlotCount
+//  frames for external readers, see FrameReader. With pipelineDepth > 0
+//  publishing overlaps the next frame, otherwise it ends each frame
+  bool publishFrames {false};
+  std::size_t publishedSlotCount {4};
+
+
+  bool isValid() const;
+
+//  the transform pass leaves next frame's cell ids behind,
+//  so the serial hashing stage only links groups
+  bool transformHashesCells() const;
+
+  std::size_t maxCellPerAxisCount() const;
+};
+
+
+//  What a real-time driver may trade for time between steps. Starts at
+//  the config's quality, stencils can shrink but not grow past the
+//  config's radius, LOD tiers can only be stretched with temporalLod
+struct SimulationQuality
+{
+  std::size_t stencilRadius {};
+
+//  multiplies every LOD tier interval by 2^lodIntervalShift
+  std::size_t lodIntervalShift {};
+};
+
+
+//  What a step is compiled for. Every combination is instantiated once
+//  and picked at init() from the config and the species rulesets, so
+//  disabled rules and features cost nothing per boid. Walls come with
+//  the bounded boundary, ObstacleAvoidance adds the obstacle scene,
+//  ApproximateNormalize steers with NormalizeMode::Approximate
+using SimulationFeatures = std::uint32_t;
+
+enum SimulationFeature : SimulationFeatures
+{
+  AlignmentRule        = 1 << 0,
+  CoherenceRule        = 1 << 1,
+  SeparationRule       = 1 << 2,
+  PeriodicBoundary     = 1 << 3,
+  ObstacleAvoidance    = 1 << 4,
+  ApproximateNormalize = 1 << 5,
+
+  AllFeatures = (1 << 6) - 1,
+};
+
+
+//  Owns a flock and everything simulating it: the arena all of its
+//  memory comes from, the thread pool and the per-boid state, grid,
+//  species rulesets and scene. step() advances the flock by one frame,
+//  the views read the state in place and stay valid until the next
+//  step(). Worker threads are pinned like the standalone simulation's,
+//  the calling thread is left to its owner
+class Simulation
+{
+  struct State;
+
+//  hashing, summing, stencil and steering, built per instruction set
+  template <CpuIsa>
+  friend struct SimulationKernels;
+
+  using StepFunction = void (Simulation::*)( const float delta );
+
+  SimulationConfig mConfig {};
+
+  AllocatorArena mAllocator {};
+  AllocatorArena* mParentAllocator {};
+  State* mState {};
+
+  SimulationQuality mQuality {};
+
+  SimulationFeatures mFeatures {};
+  CpuIsa mIsa {};
+  StepFunction mStepFunction {};
+
+  std::size_t mFrame {};
+
+
+  template <CpuIsa, SimulationFeatures>
+  void stepWith( const float delta );
+
+  void resetGroups();
+
+  void updateFlowField();
+
+  template <BoundaryMode>
+  void queryObstacles();
+
+  void rebinBoids();
+  void exportFrame();
+
+  void tuneGrid( const double frameTime );
+
+
+  template <std::size_t... Variants>
+  static constexpr std::array <StepFunction, sizeof...(Variants)> makeStepTable(
+    std::index_sequence <Variants...> );
+
+  static StepFunction stepFunction(
+    const CpuIsa,
+    const SimulationFeatures );
+
+
+public:
+  enum PerfMarker : std::size_t
+  {
+    ResetTask,
+    HashPosTask,
+    Summing,
+    NeighborStencil,
+
+//    flow field and obstacle queries steering depends on
+    RulesCalc,
+
+//    rules, avoidance and transform
+    Transform,
+    Rebin,
+    Export,
+    Total,
+
+    ObstacleAvoidanceTask,
+    FlowFieldTask,
+
+    Count,
+  };
+
+  TimePerfCounter timeCounter [PerfMarker::Count] {};
+  CyclePerfCounter cycleCounter [PerfMarker::Count] {};
+
+
+  Simulation() = default;
+  Simulation( const Simulation& ) = delete;
+  ~Simulation();
+
+
+//  false if the config is invalid, its memory can't be reserved
+//  or the frame ring it publishes to can't be created.
+//  With a parent the memory is carved from it instead of the heap,
+//  simulations sharing a parent are released in reverse
+  bool init(
+    const SimulationConfig&,
+    AllocatorArena* parent = {} );
+
+//  waits for frames still exporting
+  void drain();
+
+//  drains, then releases everything
+  void deinit();
+
+  bool initialized() const;
+
+
+  void step( const float delta );
+
+  void stepN(
+    const std::size_t count,
+    const float delta );
+
+
+  const SimulationConfig& config() const;
+
+  SimulationQuality quality() const;
+
+//  applies from the next step(), false if the
+//  quality needs more than init() allocated
+  bool setQuality( const SimulationQuality& );
+
+//  replaces flowSources[id] from the next step(), false for
+//  static sources, which are baked at init(), and unknown ids
+  bool setFlowSource(
+    const std::size_t id,
+    const FlowSource& );
+
+//  what the running step variant was compiled for
+  SimulationFeatures features() const;
+
+//  instruction set of the running kernels, see selectCpuIsa()
+  CpuIsa isa() const;
+
+//  frames simulated so far
+  std::size_t frame() const;
+
+  std::size_t boidCount() const;
+  std::size_t gridCellsPerAxis() const;
+
+  ArrayView <Vector3> positions() const;
+  ArrayView <Vector3> velocities() const;
+  ArrayView <SpeciesId> species() const;
+
+//  export summaries by frame, empty without a pipeline,
+//  frames still in flight are only complete after drain()
+  ArrayView <FrameSummary> records() const;
+
+  const MortonOctree& octree() const;
+
+
+  static std::size_t memoryRequirement(
+    const SimulationConfig& );
+};
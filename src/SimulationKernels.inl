@@ -0,0 +1,462 @@
+//  Stages whose per-boid loops dominate a step. Simulation.cpp includes
+//  this into every SimulationKernels specialization, each compiled
+//  for its own instruction set
+
+using PerfMarker = Simulation::PerfMarker;
+
+
+template <BoundaryMode boundary>
+static void
+binBoids(
+  Simulation& simulation )
+{
+  auto& state = *simulation.mState;
+  const auto& config = simulation.mConfig;
+
+  auto& boids = state.boids;
+  auto& cells = state.cells;
+  auto& groups = state.groups;
+  auto& species = state.species;
+  auto& octree = state.octree;
+
+  const auto boidCount = config.boidCount;
+  const auto gridCellsPerAxis = state.gridCellsPerAxis;
+
+  const bool cellsHashed =
+    config.transformHashesCells() == true && simulation.mFrame > 0;
+
+  const auto hashPosTask =
+  [&boids, &cells, &groups, &species, gridCellsPerAxis, cellsHashed] ( const std::size_t rangeStart, const std::size_t rangeEnd )
+  {
+    for ( SpeciesId s {}; s < species.count(); ++s )
+    {
+      const auto speciesGroupsBegin = groups.count;
+
+      const auto begin = std::max(rangeStart, species.boidsBegin(s));
+      const auto end = std::min(rangeEnd, species.boidsEnd(s));
+
+      for ( std::size_t i = begin; i < end; ++i )
+      {
+        const auto cellId = cellsHashed
+          ? boids.cellId[i]
+          : static_cast <std::uint32_t> (
+              hashPos(boids.position[i], gridCellsPerAxis, boundary) );
+
+        boids.cellId[i] = cellId;
+
+        auto& cellGroup = cells[cellId];
+
+//        species are visited in index order, so a group created
+//        before this species' first one belongs to a previous species
+        if ( cellGroup == NoGroup || cellGroup < speciesGroupsBegin )
+          cellGroup = groups.create(cellId, s, cellGroup);
+
+        boids.groupId[i] = cellGroup;
+      }
+    }
+  };
+
+  const auto buildOctreeTask =
+  [&boids, &groups, &species, &octree] ()
+  {
+    octree.reset();
+
+    for ( SpeciesId s {}; s < species.count(); ++s )
+      octree.build(
+        boids.position.data(),
+        boids.groupId.data(),
+        species.boidsBegin(s),
+        species.boidsEnd(s) );
+
+    groups.count = octree.leafCount;
+
+    std::fill_n(
+      groups.aggregates.data(), groups.count, GroupAggregate{} );
+  };
+
+  if ( config.spatialIndex == SpatialIndex::Grid )
+    hashPosTask(0, boidCount);
+  else
+    buildOctreeTask();
+
+//  threadPool.parallel_for(hashPosTask, boidCount);
+//  threadPool.waitForTasks();
+}
+
+//  one pass adds each boid to the packed aggregates of its group
+static void
+sumGroups(
+  Simulation& simulation )
+{
+  auto& state = *simulation.mState;
+  const auto& config = simulation.mConfig;
+
+  auto& boids = state.boids;
+  auto& groups = state.groups;
+
+  for ( std::size_t i {}; i < config.boidCount; ++i )
+  {
+    auto& group = groups.aggregates[boids.groupId[i]];
+
+    group.position += boids.position[i];
+    group.velocity += boids.velocity[i];
+    ++group.count;
+  }
+
+  if ( config.incrementalBinning == true )
+    state.binning.init(boids);
+}
+
+template <BoundaryMode boundary>
+static void
+gatherStencil(
+  Simulation& simulation )
+{
+  auto& state = *simulation.mState;
+  const auto& config = simulation.mConfig;
+
+  auto& cells = state.cells;
+  auto& groups = state.groups;
+
+  const auto stencilRadius = simulation.mQuality.stencilRadius;
+  const auto gridCellsPerAxis = state.gridCellsPerAxis;
+
+  const auto neighborStencilTask =
+  [&cells, &groups, stencilRadius, gridCellsPerAxis] ( const std::size_t rangeStart, const std::size_t rangeEnd )
+  {
+    const auto axisCount =
+      static_cast <std::ptrdiff_t> (gridCellsPerAxis);
+
+    const auto radius =
+      static_cast <std::ptrdiff_t> (stencilRadius);
+
+//    returns false for cells outside bounded grids,
+//    shift moves wrapped neighbors next to the stencil center
+    const auto wrapAxis =
+    [axisCount] ( std::ptrdiff_t& cell, float& shift )
+    {
+      shift = {};
+
+      if ( cell >= 0 && cell < axisCount )
+        return true;
+
+      if constexpr ( boundary == BoundaryMode::Bounded )
+        return false;
+
+      shift = cell < 0 ? -1.f : 1.f;
+      cell -= static_cast <std::ptrdiff_t> (shift) * axisCount;
+
+      return true;
+    };
+
+    for ( std::size_t g = rangeStart; g < rangeEnd; ++g )
+    {
+//      groups emptied by incremental rebinning are unlinked
+      if ( groups.aggregates[g].count == 0 )
+        continue;
+
+      const auto cellId =
+        static_cast <std::ptrdiff_t> (groups.cell[g]);
+
+      const auto cellX = cellId % axisCount;
+      const auto cellY = cellId / axisCount % axisCount;
+      const auto cellZ = cellId / axisCount / axisCount;
+
+      const auto species = groups.species[g];
+
+      Vector3 position {};
+      Vector3 velocity {};
+      std::uint32_t count {};
+
+      for ( auto dz = -radius; dz <= radius; ++dz )
+      for ( auto dy = -radius; dy <= radius; ++dy )
+      for ( auto dx = -radius; dx <= radius; ++dx )
+      {
+        auto x = cellX + dx;
+        auto y = cellY + dy;
+        auto z = cellZ + dz;
+
+        Vector3 shift {};
+
+        if ( wrapAxis(x, shift.x) == false ||
+             wrapAxis(y, shift.y) == false ||
+             wrapAxis(z, shift.z) == false )
+          continue;
+
+        for ( auto groupId = cells[x + (y + z * axisCount) * axisCount];
+              groupId != NoGroup;
+              groupId = groups.aggregates[groupId].next )
+        {
+          if ( groups.species[groupId] != species )
+            continue;
+
+          const auto& group = groups.aggregates[groupId];
+
+          position += group.position + shift * group.count;
+          velocity += group.velocity;
+          count += group.count;
+        }
+      }
+
+      auto& stencil = groups.stencil[g];
+
+      stencil.position = position;
+      stencil.velocity = velocity;
+      stencil.count = count;
+    }
+  };
+
+  state.threadPool.parallel_for(
+    neighborStencilTask, groups.count,
+    config.loopSchedule, config.loopGrainSize );
+}
+
+//  rules, avoidance and transform fused into one pass over the boids
+template <SimulationFeatures Features>
+static void
+steerBoids(
+  Simulation& simulation,
+  const float delta )
+{
+  auto& state = *simulation.mState;
+  const auto& config = simulation.mConfig;
+
+  constexpr bool hasAlignment = (Features & AlignmentRule) != 0;
+  constexpr bool hasCoherence = (Features & CoherenceRule) != 0;
+  constexpr bool hasSeparation = (Features & SeparationRule) != 0;
+  constexpr bool hasObstacles = (Features & ObstacleAvoidance) != 0;
+
+  constexpr auto normalization = (Features & ApproximateNormalize) != 0
+    ? NormalizeMode::Approximate
+    : NormalizeMode::Exact;
+
+//  approximate unit vectors may be slightly longer than 1
+  [[maybe_unused]] constexpr auto unitBound = UnitLengthBound <normalization>;
+
+  constexpr auto boundary = (Features & PeriodicBoundary) != 0
+    ? BoundaryMode::Periodic
+    : BoundaryMode::Bounded;
+
+//  periodic space has no walls, leaving only the obstacle scene to avoid
+  constexpr bool hasAvoidance =
+    boundary == BoundaryMode::Bounded || hasObstacles == true;
+
+  auto& boids = state.boids;
+  auto& cells = state.cells;
+  auto& groups = state.groups;
+  auto& species = state.species;
+  auto& flowField = state.flowField;
+  auto& lod = state.lod;
+  auto& binning = state.binning;
+
+  const auto boidCount = config.boidCount;
+  const auto incrementalBinning = config.incrementalBinning;
+  const auto transformHashesCells = config.transformHashesCells();
+  const auto gridCellsPerAxis = state.gridCellsPerAxis;
+  const auto frame = simulation.mFrame;
+
+  const bool hasLod =
+    lod.enabled();
+
+  const bool speciesInteract =
+    config.spatialIndex == SpatialIndex::Grid &&
+    species.hasInteractions();
+
+//  rules read group sums from the stencil if there is one
+  const auto& aggregates = simulation.mQuality.stencilRadius > 0
+    ? groups.stencil
+    : groups.aggregates;
+
+//  Steers and moves every boid in one pass, only the rules the variant
+//  was compiled with are evaluated. Boids the LOD scheduler skips this
+//  frame reuse the rules stored when they were last due
+  const auto steerBoidsTask =
+  [&, delta] ( const std::size_t rangeStart, const std::size_t rangeEnd )
+  {
+    const bool hasFlowField =
+      flowField.empty() == false;
+
+    for ( SpeciesId s {}; s < species.count(); ++s )
+    {
+      const auto& ruleset = species.rulesets[s];
+      const auto maxSpeed = ruleset.maxSpeed;
+
+      const auto interactions =
+        species.interactions.data() + s * species.count();
+
+      const auto begin = std::max(rangeStart, species.boidsBegin(s));
+      const auto end = std::min(rangeEnd, species.boidsEnd(s));
+
+      for ( std::size_t i = begin; i < end; ++i )
+      {
+        auto& velocity = boids.velocity[i];
+        auto& position = boids.position[i];
+
+        Vector3 heading {};
+
+        if ( hasLod == true && lod.isDue(i, frame) == false )
+        {
+          if constexpr ( hasAlignment == true )
+            heading += boids.alignment[i];
+
+          if constexpr ( hasCoherence == true )
+            heading += boids.coherence[i];
+
+          if constexpr ( hasSeparation == true )
+            heading += boids.separation[i];
+        }
+        else
+        {
+          const auto groupId = boids.groupId[i];
+          const auto& group = aggregates[groupId];
+
+          const auto neighborCount =
+            static_cast <float> (group.count);
+
+//          assert(neighborCount > 0);
+
+          const auto averagePosition = groupAverage(group.position, neighborCount);
+          const auto averageVelocity = groupAverage(group.velocity, neighborCount);
+
+          const auto center = towardsCenter <normalization> (
+            position, averagePosition );
+
+          if constexpr ( hasAlignment == true )
+          {
+            const auto steering = alignmentRule <normalization> (
+              ruleset, velocity, averageVelocity );
+
+            assert(steering.x >= -unitBound);
+            assert(steering.y >= -unitBound);
+            assert(steering.z >= -unitBound);
+            assert(steering.x <= unitBound);
+            assert(steering.y <= unitBound);
+            assert(steering.z <= unitBound);
+
+            if ( hasLod == true )
+              boids.alignment[i] = steering;
+
+            heading += steering;
+          }
+
+          if constexpr ( hasCoherence == true )
+          {
+            auto steering = coherenceRule(ruleset, center);
+
+            assert(steering.x >= -unitBound);
+            assert(steering.y >= -unitBound);
+            assert(steering.z >= -unitBound);
+            assert(steering.x <= unitBound);
+            assert(steering.y <= unitBound);
+            assert(steering.z <= unitBound);
+
+            if ( speciesInteract == true )
+            for ( auto cellGroup = cells[boids.cellId[i]];
+                  cellGroup != NoGroup;
+                  cellGroup = groups.aggregates[cellGroup].next )
+            {
+              const auto interaction =
+                interactions[groups.species[cellGroup]];
+
+              if ( cellGroup == groupId || interaction == 0.f )
+                continue;
+
+              const auto& other = groups.aggregates[cellGroup];
+
+              const auto towardsGroup =
+                other.position / static_cast <float> (other.count) - position;
+
+              steering +=
+                interaction *
+                normalize <normalization> (towardsGroup);
+            }
+
+            if ( hasLod == true )
+              boids.coherence[i] = steering;
+
+            heading += steering;
+          }
+
+          if constexpr ( hasSeparation == true )
+          {
+            const auto steering = separationRule(ruleset, center);
+
+            assert(steering.x >= -unitBound);
+            assert(steering.y >= -unitBound);
+            assert(steering.z >= -unitBound);
+            assert(steering.x <= unitBound);
+            assert(steering.y <= unitBound);
+            assert(steering.z <= unitBound);
+
+            if ( hasLod == true )
+              boids.separation[i] = steering;
+
+            heading += steering;
+          }
+        }
+
+        if ( hasFlowField == true )
+          heading += flowField.sample(position);
+
+        Vector3 avoidance {};
+
+        if constexpr ( hasObstacles == true )
+          avoidance = boids.obstacleAvoidance[i];
+
+        else
+          avoidance = wallAvoidance <boundary> (
+            position, ruleset.obstacleAvoidanceDistance );
+
+        const auto desired = hasAvoidance == true
+          ? desiredVelocity <normalization> (heading, avoidance)
+          : normalize <normalization> (heading);
+
+        const auto prevVelocity = velocity;
+
+        velocity = steerVelocity <normalization> (
+          velocity, desired, delta );
+
+        if ( hasLod == true )
+          lod.tiers[i] = lod.classify(
+            position, velocity - prevVelocity );
+
+        assert(velocity.x >= -unitBound);
+        assert(velocity.y >= -unitBound);
+        assert(velocity.z >= -unitBound);
+        assert(velocity.x <= unitBound);
+        assert(velocity.y <= unitBound);
+        assert(velocity.z <= unitBound);
+
+        assert(prevVelocity.x >= -unitBound);
+        assert(prevVelocity.y >= -unitBound);
+        assert(prevVelocity.z >= -unitBound);
+        assert(prevVelocity.x <= unitBound);
+        assert(prevVelocity.y <= unitBound);
+        assert(prevVelocity.z <= unitBound);
+
+        position = movePosition <boundary> (
+          position, velocity, maxSpeed, delta );
+
+        assert(position.x >= 0.f);
+        assert(position.y >= 0.f);
+        assert(position.z >= 0.f);
+        assert(position.x <= 1.f);
+        assert(position.y <= 1.f);
+        assert(position.z <= 1.f);
+
+        if ( incrementalBinning == true )
+          binning.updateCell(
+            boids, groups, i, static_cast <std::uint32_t> (
+              hashPos(position, gridCellsPerAxis, boundary)) );
+
+        else if ( transformHashesCells == true )
+          boids.cellId[i] = static_cast <std::uint32_t> (
+            hashPos(position, gridCellsPerAxis, boundary) );
+      }
+    }
+  };
+
+  state.threadPool.parallel_for(
+    steerBoidsTask, boidCount,
+    config.loopSchedule, config.loopGrainSize );
+}
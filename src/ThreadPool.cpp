@@ -2,6 +2,7 @@
 #include "ThreadAffinity.hpp"
 
 #include <cassert>
+#include <utility>
 
 
 void
@@ -28,8 +29,18 @@ ThreadPool::init(
 
       setThreadAffinity(mask);
 
+      auto& entry = threads[threadIndex];
+
       while ( isRunning == true )
       {
+        spinUntil(
+        [this]
+        {
+          return
+            hasPendingTask.load(std::memory_order_relaxed) == true ||
+            isRunning.load(std::memory_order_relaxed) == false;
+        }, idleSpinCount );
+
         std::unique_lock lock {mut};
 
         newTaskReceived.wait( lock,
@@ -46,17 +57,29 @@ ThreadPool::init(
           return;
         }
 
-        const auto task {std::move(pendingTask)};
-        pendingTask = {};
+        auto task {std::move(pendingTask)};
+        pendingTask = nullptr;
+
+        const auto detached =
+          std::exchange(pendingTaskDetached, false);
+
+//        marked busy before the slot reads empty,
+//        so a waiter always sees at least one of the two
+        entry.isBusy = detached == false;
+        hasPendingTask = false;
 
-        threads[threadIndex].isBusy = true;
         newTaskReceived.notify_all();
         lock.unlock();
 
         task(threadIndex);
-        threads[threadIndex].isBusy = false;
+        task = nullptr;
 
-        newTaskReceived.notify_all();
+        entry.isBusy = false;
+
+        if ( detached == true )
+          --detachedTaskCount;
+
+        notifyWaiters();
       }
     });
 }
@@ -84,6 +107,28 @@ void
 ThreadPool::push(
   TaskPrototype&& task )
 {
+  submit(std::move(task), false);
+}
+
+void
+ThreadPool::pushDetached(
+  TaskPrototype&& task )
+{
+  submit(std::move(task), true);
+}
+
+void
+ThreadPool::submit(
+  TaskPrototype&& task,
+  const bool detached )
+{
+//  the slot is usually taken by a spinning worker within a few checks
+  spinUntil(
+  [this]
+  {
+    return hasPendingTask.load(std::memory_order_relaxed) == false;
+  }, waitSpinCount );
+
   std::unique_lock lock {mut};
 
   newTaskReceived.wait( lock,
@@ -93,70 +138,94 @@ ThreadPool::push(
   });
 
   pendingTask = std::move(task);
+  pendingTaskDetached = detached;
+  hasPendingTask = true;
+
+  if ( detached == true )
+    ++detachedTaskCount;
 
   newTaskReceived.notify_one();
   lock.unlock();
 }
 
 void
-ThreadPool::push(
-  std::function <void()>&& task )
+ThreadPool::waitForTasks()
 {
-  push(
-  [task] ( const std::size_t threadId )
+  waitUntil(
+  [this]
   {
-    task();
+    if ( hasPendingTask == true )
+      return false;
+
+    for ( std::size_t i {}; i < threads.length(); ++i )
+      if ( threads[i].isBusy == true )
+        return false;
+
+    return true;
   });
 }
 
 void
-ThreadPool::parallel_for(
-  ParallelForTaskPrototype&& task,
-  const std::size_t iters,
-  std::size_t threadCount )
+ThreadPool::notifyWaiters()
 {
-  if ( threadCount == 0 )
-    threadCount = threads.length();
-
-  assert(threadCount > 0);
+  if ( blockedWaiterCount > 0 )
+  {
+    std::lock_guard lock {mut};
+    taskFinished.notify_all();
+  }
+}
 
-  const auto itersPerThread = iters / (threadCount + 1);
+std::size_t
+ThreadPool::availableThreadCount() const
+{
+  return threads.length() - std::min(
+    detachedTaskCount.load(std::memory_order_relaxed),
+    threads.length() );
+}
 
-  for ( std::size_t threadId {}, rangeEnd {}; rangeEnd < iters; ++threadId )
+bool
+ThreadPool::ChunkCounter::claim(
+  std::size_t& rangeStart,
+  std::size_t& rangeEnd )
+{
+  if ( schedule != Schedule::Guided )
   {
-    const auto rangeStart = threadId * itersPerThread;
+    rangeStart = next.fetch_add(grainSize, std::memory_order_relaxed);
 
-    rangeEnd = std::min(
-      (threadId + 1) * itersPerThread,
-      iters );
+    if ( rangeStart >= iters )
+      return false;
 
-    if ( rangeEnd != iters )
-      push(
-      [task, rangeStart, rangeEnd] ( const std::size_t )
-      {
-        task(rangeStart, rangeEnd);
-      });
-    else
-      task(rangeStart, rangeEnd);
+    rangeEnd = std::min(rangeStart + grainSize, iters);
+
+    return true;
   }
-}
 
-void
-ThreadPool::waitForTasks()
-{
-  std::unique_lock lock (mut);
+  rangeStart = next.load(std::memory_order_relaxed);
 
-  newTaskReceived.wait( lock,
-  [this]
+  do
   {
-    return pendingTask == nullptr;
-  });
+    if ( rangeStart >= iters )
+      return false;
 
-  lock.unlock();
+    const auto chunkSize = std::max(
+      (iters - rangeStart) / (participantCount * 2),
+      grainSize );
 
-  for ( std::size_t i {}; i < threads.length(); ++i )
-  {
-    while ( threads[i].isBusy == true )
-      ;
+    rangeEnd = std::min(rangeStart + chunkSize, iters);
   }
+  while ( next.compare_exchange_weak(
+            rangeStart, rangeEnd,
+            std::memory_order_relaxed ) == false );
+
+  return true;
+}
+
+std::size_t
+ThreadPool::memoryRequirement(
+  const std::size_t threadCount )
+{
+  return
+    sizeof(ThreadEntry) * threadCount +
+    alignof(ThreadEntry) +
+    sizeof(std::size_t);
 }
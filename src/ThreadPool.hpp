@@ -1,35 +1,107 @@
 #pragma once
 
 #include "Containers.hpp"
+#include "InlineTask.hpp"
 
 #include <mutex>
+#include <atomic>
 #include <thread>
-#include <functional>
+#include <algorithm>
+#include <type_traits>
 #include <condition_variable>
 
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+
+//  spin loop hint, frees pipeline resources for the SMT sibling
+inline void
+cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
 
 struct ThreadPool
 {
-  struct ThreadEntry
+//  one cache line per worker, so finishing workers
+//  don't invalidate the line a waiter spins on
+  struct alignas(64) ThreadEntry
   {
-    volatile bool isBusy {};
+    std::atomic_bool isBusy {};
     std::thread thread {};
   };
 
-  Array <ThreadEntry> threads {};
+  Array <ThreadEntry, alignof(ThreadEntry)> threads {};
+
+  std::atomic_bool isRunning {};
 
-  bool isRunning {};
+//  checks spent spinning before a thread blocks on a condition variable,
+//  0 blocks right away for low CPU use, larger values cut wake-up latency.
+//  waitSpinCount applies to submitting and waiting threads,
+//  idleSpinCount to workers waiting for a task
+  std::size_t waitSpinCount {1024};
+  std::size_t idleSpinCount {1024};
 
   mutable std::mutex mut {};
   std::condition_variable newTaskReceived {};
+  std::condition_variable taskFinished {};
 
-  using TaskPrototype =
-    std::function <void( const std::size_t threadId )>;
+  std::atomic_bool hasPendingTask {};
+  std::atomic_size_t blockedWaiterCount {};
 
-  using ParallelForTaskPrototype =
-    std::function <void( const std::size_t rangeStart, const std::size_t rangeEnd )>;
+  using TaskPrototype =
+    InlineTask <void( const std::size_t threadId )>;
 
   TaskPrototype pendingTask {};
+  bool pendingTaskDetached {};
+
+  std::atomic_size_t detachedTaskCount {};
+
+
+  enum class Schedule
+  {
+//    threadCount + 1 equal ranges
+    Static,
+
+//    grainSize chunks taken from a shared counter
+    Dynamic,
+
+//    chunks shrinking with the remaining work, never below grainSize
+    Guided,
+  };
+
+//  box of a 2D or 3D iteration space, axis 0 varies fastest
+  template <std::size_t Dims>
+  struct Range
+  {
+    std::size_t begin [Dims] {};
+    std::size_t end [Dims] {};
+  };
+
+  using Range2 = Range <2>;
+  using Range3 = Range <3>;
+
+//  hands out chunks of [0, iters) to the loop participants
+  struct ChunkCounter
+  {
+    alignas(64) std::atomic_size_t next {};
+
+    std::size_t iters {};
+    std::size_t grainSize {};
+    std::size_t participantCount {};
+    Schedule schedule {};
+
+
+    bool claim(
+      std::size_t& rangeStart,
+      std::size_t& rangeEnd );
+  };
 
 
   void init(
@@ -41,12 +113,272 @@ struct ThreadPool
 
   void push( TaskPrototype&& );
 
-  void push( std::function <void()>&& task );
+//  runs outside of waitForTasks() and parallel_for(),
+//  the task has to signal its own completion
+  void pushDetached( TaskPrototype&& );
 
+  void submit(
+    TaskPrototype&&,
+    const bool detached );
+
+//  accepts callables taking either a thread id or nothing
+  template <typename Task>
+  void push( Task&& );
+
+//  pushed chunks reference the task instead of copying it,
+//  so it must stay alive until waitForTasks() returns
+  template <typename Task>
+  void parallel_for(
+    Task&,
+    const std::size_t iters,
+    std::size_t threadCount = {} );
+
+//  returns once every chunk is done, task( rangeStart, rangeEnd )
+//  may be called several times per thread
+  template <typename Task>
   void parallel_for(
-    ParallelForTaskPrototype&&,
+    Task&,
     const std::size_t iters,
+    const Schedule,
+    const std::size_t grainSize = {},
+    std::size_t threadCount = {} );
+
+//  splits the space into tiles of tileSize, calls task( const Range& )
+//  once per tile, returns once every tile is done
+  template <typename Task, std::size_t Dims>
+  void parallel_for(
+    Task&,
+    const std::size_t (&size) [Dims],
+    const std::size_t (&tileSize) [Dims],
+    const Schedule = Schedule::Dynamic,
     std::size_t threadCount = {} );
 
   void waitForTasks();
+
+//  workers not occupied by detached tasks
+  std::size_t availableThreadCount() const;
+
+//  spins, then blocks until a finishing task makes the condition true
+  template <typename Condition>
+  void waitUntil( Condition&& );
+
+//  wakes blocked waitUntil() callers, tasks call it to publish
+//  progress that waiters depend on before the task returns
+  void notifyWaiters();
+
+
+  static std::size_t memoryRequirement(
+    const std::size_t threadCount );
 };
+
+
+template <typename Condition>
+bool
+spinUntil(
+  Condition&& condition,
+  const std::size_t spinCount )
+{
+  for ( std::size_t i {}; i < spinCount; ++i )
+  {
+    if ( condition() == true )
+      return true;
+
+    cpuRelax();
+  }
+
+  return condition();
+}
+
+template <typename Condition>
+void
+ThreadPool::waitUntil(
+  Condition&& condition )
+{
+  if ( spinUntil(condition, waitSpinCount) == true )
+    return;
+
+  std::unique_lock lock {mut};
+
+//  workers only notify when they see a blocked waiter,
+//  the counter is sequentially consistent with their busy flags
+  ++blockedWaiterCount;
+
+  taskFinished.wait(lock, condition);
+
+  --blockedWaiterCount;
+}
+
+
+template <typename Task>
+void
+ThreadPool::push(
+  Task&& task )
+{
+  if constexpr ( std::is_invocable_v <Task&, std::size_t> )
+    push(TaskPrototype{std::forward <Task> (task)});
+
+  else
+    push(TaskPrototype{
+    [task = std::forward <Task> (task)] ( const std::size_t ) mutable
+    {
+      task();
+    }});
+}
+
+template <typename Task>
+void
+ThreadPool::parallel_for(
+  Task& task,
+  const std::size_t iters,
+  std::size_t threadCount )
+{
+  if ( threadCount == 0 )
+    threadCount = availableThreadCount();
+
+  const auto itersPerThread = iters / (threadCount + 1);
+
+//  a pool without workers runs the loop on the caller
+  if ( threadCount == 0 || itersPerThread == 0 )
+  {
+    task(std::size_t{}, iters);
+    return;
+  }
+
+  for ( std::size_t threadId {}, rangeEnd {}; rangeEnd < iters; ++threadId )
+  {
+    const auto rangeStart = threadId * itersPerThread;
+
+    rangeEnd = threadId < threadCount
+      ? rangeStart + itersPerThread
+      : iters;
+
+    if ( rangeEnd != iters )
+      push(TaskPrototype{
+      [&task, rangeStart, rangeEnd] ( const std::size_t )
+      {
+        task(rangeStart, rangeEnd);
+      }});
+    else
+      task(rangeStart, rangeEnd);
+  }
+}
+
+template <typename Task>
+void
+ThreadPool::parallel_for(
+  Task& task,
+  const std::size_t iters,
+  const Schedule schedule,
+  const std::size_t grainSize,
+  std::size_t threadCount )
+{
+  if ( schedule == Schedule::Static )
+  {
+    parallel_for(task, iters, threadCount);
+    waitForTasks();
+    return;
+  }
+
+  if ( threadCount == 0 )
+    threadCount = availableThreadCount();
+
+  ChunkCounter counter {};
+  counter.iters = iters;
+  counter.grainSize = std::max(grainSize, std::size_t{1});
+  counter.schedule = schedule;
+
+  const auto chunkCount =
+    (iters + counter.grainSize - 1) / counter.grainSize;
+
+//  no point in waking more workers than there are chunks
+  const auto workerCount = std::min(
+    threadCount, std::max(chunkCount, std::size_t{1}) - 1 );
+
+  counter.participantCount = workerCount + 1;
+
+  std::atomic_size_t finishedCount {};
+
+  const auto participant =
+  [&task, &counter] ()
+  {
+    std::size_t rangeStart {};
+    std::size_t rangeEnd {};
+
+    while ( counter.claim(rangeStart, rangeEnd) == true )
+      task(rangeStart, rangeEnd);
+  };
+
+  for ( std::size_t i {}; i < workerCount; ++i )
+    push(TaskPrototype{
+    [&participant, &finishedCount] ( const std::size_t )
+    {
+      participant();
+      ++finishedCount;
+    }});
+
+  participant();
+
+//  counter and task live on this stack frame
+  waitUntil(
+  [&finishedCount, workerCount]
+  {
+    return finishedCount.load() == workerCount;
+  });
+}
+
+template <typename Task, std::size_t Dims>
+void
+ThreadPool::parallel_for(
+  Task& task,
+  const std::size_t (&size) [Dims],
+  const std::size_t (&tileSize) [Dims],
+  const Schedule schedule,
+  std::size_t threadCount )
+{
+  std::size_t tilesPerAxis [Dims] {};
+  std::size_t tileCount {1};
+
+  for ( std::size_t axis {}; axis < Dims; ++axis )
+  {
+    assert(tileSize[axis] > 0);
+
+    tilesPerAxis[axis] =
+      (size[axis] + tileSize[axis] - 1) / tileSize[axis];
+
+    tileCount *= tilesPerAxis[axis];
+  }
+
+  const auto tileTask =
+  [&task, &size, &tileSize, &tilesPerAxis] ( const std::size_t rangeStart, const std::size_t rangeEnd )
+  {
+    for ( auto tileId = rangeStart; tileId < rangeEnd; ++tileId )
+    {
+      Range <Dims> range {};
+
+      for ( std::size_t axis {}, index = tileId; axis < Dims; ++axis )
+      {
+        range.begin[axis] = index % tilesPerAxis[axis] * tileSize[axis];
+        range.end[axis] = std::min(
+          range.begin[axis] + tileSize[axis],
+          size[axis] );
+
+        index /= tilesPerAxis[axis];
+      }
+
+      task(static_cast <const Range <Dims>&> (range));
+    }
+  };
+
+  if ( threadCount == 0 )
+    threadCount = availableThreadCount();
+
+//  static scheduling hands every participant one equal share of tiles
+  const auto grainSize = schedule == Schedule::Static
+    ? (tileCount + threadCount) / (threadCount + 1)
+    : std::size_t{1};
+
+  parallel_for(
+    tileTask, tileCount,
+    schedule == Schedule::Static ? Schedule::Dynamic : schedule,
+    grainSize, threadCount );
+}
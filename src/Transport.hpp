@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+
+//  Message passing between the ranks of a domain decomposition.
+//  Communication happens in rounds: every rank sends to the peers it
+//  exchanges with, calls barrier(), then receives what those peers sent
+//  during the same round. A peer that gets read from has to send every
+//  round, even if only zero bytes
+class Transport
+{
+public:
+  virtual ~Transport() = default;
+
+
+  virtual std::size_t rank() const = 0;
+  virtual std::size_t rankCount() const = 0;
+
+//  largest message a single send() accepts
+  virtual std::size_t messageCapacity() const = 0;
+
+//  false if the message exceeds messageCapacity()
+  virtual bool send(
+    const std::size_t peer,
+    const void* data,
+    const std::size_t bytes ) = 0;
+
+//  message the peer sent this round,
+//  valid until the next barrier()
+  virtual const void* receive(
+    const std::size_t peer,
+    std::size_t& bytes ) = 0;
+
+  virtual void barrier() = 0;
+};
@@ -0,0 +1,921 @@
+#include "Validation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <string>
+#include <system_error>
+#include <iostream>
+
+
+namespace
+{
+struct SnapshotHeader
+{
+  char magic [8] {'B', 'O', 'I', 'D', 'S', 'N', 'A', 'P'};
+  std::uint32_t version {1};
+  std::uint32_t vectorSize {sizeof(Vector3)};
+  std::uint64_t boidCount {};
+  std::uint64_t frame {};
+};
+
+
+struct Scenario
+{
+  const char* name {};
+  void (*configure)( SimulationConfig& ) {};
+};
+
+const Scenario Scenarios []
+{
+  {"bounded",
+    [] ( SimulationConfig& ) {}},
+
+  {"periodic",
+    [] ( SimulationConfig& config )
+    {
+      config.boundary = BoundaryMode::Periodic;
+    }},
+
+  {"stencil",
+    [] ( SimulationConfig& config )
+    {
+      config.stencilRadius = 1;
+    }},
+
+  {"periodic-stencil",
+    [] ( SimulationConfig& config )
+    {
+      config.boundary = BoundaryMode::Periodic;
+      config.stencilRadius = 1;
+    }},
+
+  {"species",
+    [] ( SimulationConfig& config )
+    {
+      config.speciesCount = 3;
+    }},
+
+  {"interactions",
+    [] ( SimulationConfig& config )
+    {
+      static const BoidRuleset rulesets []
+      {
+        {},
+        {{0.1f, 0.4f, 0.05f}, 0.08f, 0.3f},
+        {{0.3f, 0.05f, 0.2f}, 0.03f, 0.5f},
+      };
+
+//      species 2 chases species 0, which flees it,
+//      species 1 keeps clear of both
+      static const float interactions []
+      {
+         0.f,   0.2f, -0.6f,
+        -0.1f,  0.f,  -0.4f,
+         0.5f, -0.3f,  0.f,
+      };
+
+      config.speciesCount = 3;
+      config.speciesRulesets = {rulesets, std::size(rulesets)};
+      config.speciesInteractions = {interactions, std::size(interactions)};
+      config.stencilRadius = 1;
+    }},
+
+  {"incremental",
+    [] ( SimulationConfig& config )
+    {
+      config.incrementalBinning = true;
+      config.fullRebinInterval = 16;
+    }},
+
+  {"pipelined",
+    [] ( SimulationConfig& config )
+    {
+      config.pipelineDepth = 2;
+    }},
+
+  {"approximate",
+    [] ( SimulationConfig& config )
+    {
+      config.normalization = NormalizeMode::Approximate;
+    }},
+};
+
+
+SimulationConfig
+scenarioConfig(
+  const Scenario& scenario,
+  const ValidationConfig& validation )
+{
+  SimulationConfig config {};
+
+  config.boidCount = validation.boidCount;
+  config.cellPerAxisCount = validation.cellPerAxisCount;
+  config.threadCount = validation.threadCount;
+  config.frameCount = validation.frameCount;
+  config.seed = validation.seed;
+
+//  independent of how the build sets the default
+  config.normalization = NormalizeMode::Exact;
+
+  scenario.configure(config);
+
+  return config;
+}
+
+//  hands compare a reference of the config and the arena
+//  it comes from, with extraBytes left for compare
+template <typename Compare>
+bool
+withReference(
+  const SimulationConfig& config,
+  const std::size_t extraBytes,
+  Compare compare )
+{
+  AllocatorArena allocator {};
+
+  if ( allocator.reserve(ReferenceFlock::memoryRequirement(config) + extraBytes) == false )
+    return false;
+
+  bool succeeded {};
+
+  {
+    ReferenceFlock reference {allocator, config};
+
+    succeeded = compare(reference, allocator);
+  }
+
+  allocator.free();
+
+  return succeeded;
+}
+
+void
+mergeError(
+  StateError& error,
+  const StateError& frameError )
+{
+  if ( frameError.maxPositionError > error.maxPositionError )
+  {
+    error.maxPositionError = frameError.maxPositionError;
+    error.worstBoid = frameError.worstBoid;
+  }
+
+  error.maxVelocityError = std::max(
+    error.maxVelocityError, frameError.maxVelocityError );
+
+  error.mismatchCount += frameError.mismatchCount;
+}
+
+void
+printError(
+  const StateError& error )
+{
+  std::cout <<
+    "position error " << error.maxPositionError <<
+    " (boid " << error.worstBoid << ")" <<
+    ", velocity error " << error.maxVelocityError <<
+    ", " << error.mismatchCount << " mismatches";
+}
+
+//  one kernel variant against the reference
+bool
+validateVariant(
+  const Scenario& scenario,
+  const SimulationConfig& config,
+  const ValidationConfig& validation )
+{
+  Simulation simulation {};
+
+  std::cout << scenario.name << " " << cpuIsaName(config.maxIsa) << ": ";
+
+  if ( simulation.init(config) == false )
+  {
+    std::cout << "invalid config or out of memory\n";
+    return false;
+  }
+
+  StateError error {};
+
+//  Small groups make rules ill-conditioned: a rounding difference in a
+//  group average can turn a rule's direction noticeably, and the flock
+//  amplifies that from frame to frame. So every frame restarts the
+//  reference from the simulation's state and compares only that step
+  const auto compare =
+  [&simulation, &config, &validation, &error] ( ReferenceFlock& reference, AllocatorArena& )
+  {
+    for ( std::size_t frame {}; frame < validation.frameCount; ++frame )
+    {
+      reference.copyState(simulation);
+
+      simulation.step(validation.delta);
+      reference.step(validation.delta);
+
+      mergeError(error, compareStates(
+        simulation.positions(), simulation.velocities(),
+        reference.position, reference.velocity,
+        config.boundary, validation.runTolerance ));
+    }
+
+    simulation.drain();
+
+    return
+      error.mismatchCount <=
+      validation.maxMismatchShare * config.boidCount * validation.frameCount;
+  };
+
+  const bool passed = withReference(
+    config, 0, compare );
+
+  simulation.deinit();
+
+  printError(error);
+  std::cout << (passed ? ", passed\n" : ", FAILED\n");
+
+  return passed;
+}
+
+//  the reference against the snapshot recorded from it
+bool
+validateGolden(
+  const Scenario& scenario,
+  const SimulationConfig& config,
+  const ValidationConfig& validation )
+{
+  std::cout << scenario.name << " golden: ";
+
+  const std::filesystem::path directory =
+    validation.goldenDirectory != nullptr
+      ? validation.goldenDirectory
+      : BOIDS_SOURCE_DIR "/golden";
+
+  if ( validation.recordGolden == true )
+  {
+    std::error_code errorCode {};
+    std::filesystem::create_directories(directory, errorCode);
+  }
+
+  const auto path =
+    (directory / (std::string{scenario.name} + ".snapshot")).string();
+
+  StateError error {};
+  const char* failure {};
+  bool written {};
+
+  const auto compare =
+  [&] ( ReferenceFlock& reference, AllocatorArena& allocator )
+  {
+    reference.spawn();
+
+    for ( std::size_t frame {}; frame < validation.frameCount; ++frame )
+      reference.step(validation.delta);
+
+    std::size_t frame {};
+    Array <Vector3> positions {};
+    Array <Vector3> velocities {};
+
+    if ( validation.recordGolden == true )
+    {
+      written = writeSnapshot(
+        path.c_str(), validation.frameCount,
+        reference.position, reference.velocity );
+
+      if ( written == false )
+        failure = "can't write the snapshot";
+
+      return written;
+    }
+
+    if ( readSnapshot(path.c_str(), config.boidCount, allocator, frame, positions, velocities) == false )
+    {
+      failure = "missing or unreadable snapshot, record it with recordGolden";
+      return false;
+    }
+
+    if ( frame != validation.frameCount )
+    {
+      failure = "the snapshot is of another frame";
+      return false;
+    }
+
+    error = compareStates(
+      reference.position, reference.velocity,
+      positions, velocities,
+      config.boundary, validation.goldenTolerance );
+
+    return error.mismatchCount == 0;
+  };
+
+  const bool passed = withReference(
+    config, snapshotMemoryRequirement(config.boidCount), compare );
+
+  if ( written == true )
+    std::cout << "wrote " << path << "\n";
+
+  else if ( failure != nullptr )
+    std::cout << path << ": " << failure << ", FAILED\n";
+
+  else
+  {
+    printError(error);
+    std::cout << (passed ? ", passed\n" : ", FAILED\n");
+  }
+
+  return passed;
+}
+
+//  how often a tiled loop visited each cell of a size[0] * size[1]
+//  or size[0] * size[1] * size[2] space, indexed with axis 0 fastest
+template <std::size_t Dims>
+bool
+validateTiledLoop(
+  ThreadPool& threadPool,
+  Array <std::atomic_size_t>& visits,
+  const std::size_t (&size) [Dims],
+  const std::size_t (&tileSize) [Dims],
+  const ThreadPool::Schedule schedule,
+  std::size_t& wrongCount )
+{
+  std::size_t cellCount {1};
+
+  for ( std::size_t axis {}; axis < Dims; ++axis )
+    cellCount *= size[axis];
+
+  assert(cellCount <= visits.length());
+
+  for ( std::size_t i {}; i < cellCount; ++i )
+    visits[i].store(0, std::memory_order_relaxed);
+
+  auto visit =
+  [&visits, &size] ( const ThreadPool::Range <Dims>& range )
+  {
+    const auto depthBegin = Dims > 2 ? range.begin[Dims - 1] : 0;
+    const auto depthEnd = Dims > 2 ? range.end[Dims - 1] : 1;
+
+    for ( auto z = depthBegin; z < depthEnd; ++z )
+    for ( auto y = range.begin[1]; y < range.end[1]; ++y )
+    for ( auto x = range.begin[0]; x < range.end[0]; ++x )
+      visits[x + (y + z * size[1]) * size[0]].fetch_add(
+        1, std::memory_order_relaxed );
+  };
+
+  threadPool.parallel_for(visit, size, tileSize, schedule);
+
+  std::size_t runWrongCount {};
+
+  for ( std::size_t i {}; i < cellCount; ++i )
+    runWrongCount += visits[i].load(std::memory_order_relaxed) != 1;
+
+  wrongCount += runWrongCount;
+
+  return runWrongCount == 0;
+}
+
+//  every schedule of the tiled loops on spaces whose sizes
+//  aren't multiples of the tiles, so the last tiles are cut off
+bool
+validateTiledLoops(
+  const ValidationConfig& validation )
+{
+  std::cout << "tiled loops: ";
+
+  constexpr std::size_t size2 [] {37, 23};
+  constexpr std::size_t tileSize2 [] {8, 5};
+
+  constexpr std::size_t size3 [] {13, 7, 11};
+  constexpr std::size_t tileSize3 [] {4, 3, 5};
+
+  constexpr std::size_t maxCellCount {
+    std::max(size2[0] * size2[1], size3[0] * size3[1] * size3[2]) };
+
+  AllocatorArena allocator {};
+
+  if ( allocator.reserve(
+        ThreadPool::memoryRequirement(validation.threadCount) +
+        sizeof(std::atomic_size_t) * maxCellCount +
+        sizeof(std::size_t) ) == false )
+  {
+    std::cout << "out of memory, FAILED\n";
+    return false;
+  }
+
+  std::size_t wrongCount {};
+  bool passed {true};
+
+  {
+    Array <std::atomic_size_t> visits {allocator, maxCellCount};
+
+    ThreadPool threadPool {};
+    threadPool.init(allocator, validation.threadCount);
+
+    for ( const auto schedule :
+          {ThreadPool::Schedule::Static,
+           ThreadPool::Schedule::Dynamic,
+           ThreadPool::Schedule::Guided} )
+    {
+      passed &= validateTiledLoop(
+        threadPool, visits, size2, tileSize2, schedule, wrongCount );
+
+      passed &= validateTiledLoop(
+        threadPool, visits, size3, tileSize3, schedule, wrongCount );
+    }
+
+    threadPool.deinit();
+  }
+
+  allocator.free();
+
+  std::cout <<
+    wrongCount << " cells missed or repeated" <<
+    (passed ? ", passed\n" : ", FAILED\n");
+
+  return passed;
+}
+
+}
+
+
+ReferenceFlock::ReferenceFlock(
+  AllocatorArena& allocator,
+  const SimulationConfig& simulationConfig )
+  : config{simulationConfig}
+  , position{allocator, config.boidCount}
+  , velocity{allocator, config.boidCount}
+  , species{allocator, config.boidCount}
+  , cellPosition{allocator,
+      config.cellPerAxisCount * config.cellPerAxisCount *
+      config.cellPerAxisCount * config.speciesCount}
+  , cellVelocity{allocator, cellPosition.length()}
+  , cellCount{allocator, cellPosition.length()}
+{
+  assert(supports(config) == true);
+}
+
+void
+ReferenceFlock::copyState(
+  const Simulation& simulation )
+{
+  const auto positions = simulation.positions();
+  const auto velocities = simulation.velocities();
+  const auto speciesIds = simulation.species();
+
+  assert(positions.length() == position.length());
+
+  std::copy(positions.begin(), positions.end(), position.data());
+  std::copy(velocities.begin(), velocities.end(), velocity.data());
+  std::copy(speciesIds.begin(), speciesIds.end(), species.data());
+}
+
+void
+ReferenceFlock::spawn()
+{
+  assert(config.seed != 0);
+
+  std::uniform_real_distribution dist(0.f, 1.f);
+  std::minstd_rand0 engine {config.seed};
+
+  const auto boidCount = position.length();
+
+  for ( std::size_t i {}; i < boidCount; ++i )
+  {
+    position[i] = { dist(engine), dist(engine), dist(engine) };
+    velocity[i] = {};
+
+    if ( config.boundary == BoundaryMode::Periodic )
+      velocity[i] = Vector3
+      {
+        dist(engine) - 0.5f,
+        dist(engine) - 0.5f,
+        dist(engine) - 0.5f,
+      }.normalized();
+  }
+
+//  species own consecutive even shares, see SpeciesTable
+  for ( std::size_t s {}; s < config.speciesCount; ++s )
+    std::fill(
+      species.data() + boidCount * s / config.speciesCount,
+      species.data() + boidCount * (s + 1) / config.speciesCount,
+      static_cast <SpeciesId> (s) );
+}
+
+std::size_t
+ReferenceFlock::hashCell(
+  const Vector3& point ) const
+{
+  const auto cellsPerAxis = config.cellPerAxisCount;
+
+  std::size_t cell {};
+  std::size_t stride {1};
+
+  for ( const auto coordinate : {point.x, point.y, point.z} )
+  {
+    auto axisCell =
+      static_cast <std::size_t> (coordinate * cellsPerAxis);
+
+//    the far face belongs to the last cell, or wraps to the first
+    if ( axisCell >= cellsPerAxis )
+      axisCell = config.boundary == BoundaryMode::Periodic
+        ? 0
+        : cellsPerAxis - 1;
+
+    cell += axisCell * stride;
+    stride *= cellsPerAxis;
+  }
+
+  return cell;
+}
+
+void
+ReferenceFlock::sumCells()
+{
+  std::fill_n(cellPosition.data(), cellPosition.length(), Vector3{});
+  std::fill_n(cellVelocity.data(), cellVelocity.length(), Vector3{});
+  std::fill_n(cellCount.data(), cellCount.length(), 0);
+
+  for ( std::size_t i {}; i < position.length(); ++i )
+  {
+    const auto group =
+      hashCell(position[i]) * config.speciesCount + species[i];
+
+    cellPosition[group] += position[i];
+    cellVelocity[group] += velocity[i];
+    cellCount[group] += 1;
+  }
+}
+
+void
+ReferenceFlock::gatherCells(
+  const std::size_t cellId,
+  const SpeciesId speciesId,
+  Vector3& positionSum,
+  Vector3& velocitySum,
+  std::size_t& count ) const
+{
+  const auto axisCount =
+    static_cast <std::ptrdiff_t> (config.cellPerAxisCount);
+
+  const auto radius =
+    static_cast <std::ptrdiff_t> (config.stencilRadius);
+
+  const auto cell =
+    static_cast <std::ptrdiff_t> (cellId);
+
+  const std::ptrdiff_t center []
+  {
+    cell % axisCount,
+    cell / axisCount % axisCount,
+    cell / axisCount / axisCount,
+  };
+
+  positionSum = {};
+  velocitySum = {};
+  count = {};
+
+  for ( auto dz = -radius; dz <= radius; ++dz )
+  for ( auto dy = -radius; dy <= radius; ++dy )
+  for ( auto dx = -radius; dx <= radius; ++dx )
+  {
+    std::ptrdiff_t neighbor [] {
+      center[0] + dx, center[1] + dy, center[2] + dz };
+
+    float shift [3] {};
+    bool inside {true};
+
+    for ( std::size_t axis {}; axis < 3; ++axis )
+    {
+      if ( neighbor[axis] >= 0 && neighbor[axis] < axisCount )
+        continue;
+
+      if ( config.boundary == BoundaryMode::Bounded )
+        inside = false;
+
+//      a wrapped neighbor counts as lying next to the center cell
+      shift[axis] = neighbor[axis] < 0 ? -1.f : 1.f;
+      neighbor[axis] -= static_cast <std::ptrdiff_t> (shift[axis]) * axisCount;
+    }
+
+    if ( inside == false )
+      continue;
+
+    const auto group =
+      (neighbor[0] + (neighbor[1] + neighbor[2] * axisCount) * axisCount) *
+      config.speciesCount + speciesId;
+
+    const auto groupCount = cellCount[group];
+
+    if ( groupCount == 0 )
+      continue;
+
+    positionSum +=
+      cellPosition[group] +
+      Vector3{shift[0], shift[1], shift[2]} * groupCount;
+
+    velocitySum += cellVelocity[group];
+    count += groupCount;
+  }
+}
+
+void
+ReferenceFlock::step(
+  const float delta )
+{
+  sumCells();
+
+  const auto speciesCount = config.speciesCount;
+
+  const auto maxCoordinate =
+    1.f - std::numeric_limits <float>::epsilon();
+
+  for ( std::size_t i {}; i < position.length(); ++i )
+  {
+    const auto& ruleset = config.speciesRulesets.length() > 0
+      ? config.speciesRulesets[species[i]]
+      : config.ruleset;
+
+    const auto& weights = ruleset.weights;
+    const auto margin = ruleset.obstacleAvoidanceDistance;
+
+    const auto cellId = hashCell(position[i]);
+
+    Vector3 positionSum {};
+    Vector3 velocitySum {};
+    std::size_t count {};
+
+    if ( config.stencilRadius > 0 )
+      gatherCells(cellId, species[i], positionSum, velocitySum, count);
+
+    else
+    {
+      const auto group = cellId * config.speciesCount + species[i];
+
+      positionSum = cellPosition[group];
+      velocitySum = cellVelocity[group];
+      count = cellCount[group];
+    }
+
+    const auto averagePosition = positionSum / count;
+    const auto averageVelocity = velocitySum / count;
+
+    auto heading =
+      weights.alignment * (averageVelocity - velocity[i]).normalized() +
+      weights.coherence * (averagePosition - position[i]).normalized() +
+      weights.separation * (position[i] - averagePosition).normalized();
+
+//    other species pull or push towards their centroid in the own cell
+    if ( config.speciesInteractions.length() > 0 )
+      for ( SpeciesId other {}; other < speciesCount; ++other )
+      {
+        const auto interaction =
+          config.speciesInteractions[species[i] * speciesCount + other];
+
+        const auto group = cellId * speciesCount + other;
+
+        if ( other == species[i] ||
+             interaction == 0.f ||
+             cellCount[group] == 0 )
+          continue;
+
+        heading += interaction * (
+          cellPosition[group] / cellCount[group] - position[i] ).normalized();
+      }
+
+    Vector3 avoidance {};
+
+    if ( config.boundary == BoundaryMode::Bounded )
+      for ( std::size_t axis {}; axis < 3; ++axis )
+      {
+        const auto coordinate = (&position[i].x)[axis];
+
+        if ( coordinate > 1 - margin )
+          (&avoidance.x)[axis] = -1;
+
+        else if ( coordinate < margin )
+          (&avoidance.x)[axis] = 1;
+      }
+
+    const auto desiredVelocity =
+      avoidance.length_squared() > 0.f
+        ? avoidance.normalized()
+        : heading.normalized();
+
+    velocity[i] = (
+      velocity[i] + (desiredVelocity - velocity[i]) * delta ).normalized();
+
+    position[i] += velocity[i] * ruleset.maxSpeed * delta;
+
+    for ( std::size_t axis {}; axis < 3; ++axis )
+    {
+      auto& coordinate = (&position[i].x)[axis];
+
+      if ( config.boundary == BoundaryMode::Bounded )
+        coordinate = std::clamp(coordinate, 0.f, maxCoordinate);
+
+      else
+      {
+        coordinate -= std::floor(coordinate);
+
+        if ( coordinate >= 1.f )
+          coordinate = 0.f;
+      }
+    }
+  }
+}
+
+bool
+ReferenceFlock::supports(
+  const SimulationConfig& config )
+{
+  return
+    config.isValid() == true &&
+    config.spatialIndex == SpatialIndex::Grid &&
+    config.adaptiveGrid == false &&
+    config.obstacles.length() == 0 &&
+    config.flowSources.length() == 0 &&
+    config.temporalLod == false;
+}
+
+std::size_t
+ReferenceFlock::memoryRequirement(
+  const SimulationConfig& config )
+{
+  const auto groupCount =
+    config.cellPerAxisCount * config.cellPerAxisCount *
+    config.cellPerAxisCount * config.speciesCount;
+
+  return
+    (sizeof(Vector3) * 2 + sizeof(SpeciesId)) * config.boidCount +
+    (sizeof(Vector3) * 2 + sizeof(std::size_t)) * groupCount +
+    sizeof(std::size_t) * 20;
+}
+
+
+StateError
+compareStates(
+  const ArrayView <Vector3>& positions,
+  const ArrayView <Vector3>& velocities,
+  const ArrayView <Vector3>& expectedPositions,
+  const ArrayView <Vector3>& expectedVelocities,
+  const BoundaryMode boundary,
+  const StateTolerance& tolerance )
+{
+  assert(positions.length() == expectedPositions.length());
+  assert(velocities.length() == expectedVelocities.length());
+
+  StateError error {};
+
+  for ( std::size_t i {}; i < positions.length(); ++i )
+  {
+    auto offset = positions[i] - expectedPositions[i];
+
+    if ( boundary == BoundaryMode::Periodic )
+      offset =
+      {
+        offset.x - std::round(offset.x),
+        offset.y - std::round(offset.y),
+        offset.z - std::round(offset.z),
+      };
+
+    const auto positionError = offset.length();
+
+    const auto velocityError =
+      (velocities[i] - expectedVelocities[i]).length();
+
+//    NaNs fail every comparison, so they count as mismatches
+    if ( (positionError <= tolerance.position &&
+          velocityError <= tolerance.velocity) == false )
+      ++error.mismatchCount;
+
+    if ( positionError > error.maxPositionError )
+    {
+      error.maxPositionError = positionError;
+      error.worstBoid = i;
+    }
+
+    error.maxVelocityError = std::max(
+      error.maxVelocityError, velocityError );
+  }
+
+  return error;
+}
+
+
+bool
+writeSnapshot(
+  const char* path,
+  const std::size_t frame,
+  const ArrayView <Vector3>& positions,
+  const ArrayView <Vector3>& velocities )
+{
+  assert(positions.length() == velocities.length());
+
+  const auto file = std::fopen(path, "wb");
+
+  if ( file == nullptr )
+    return false;
+
+  SnapshotHeader header {};
+  header.boidCount = positions.length();
+  header.frame = frame;
+
+  const auto boidCount = positions.length();
+
+  const bool written =
+    std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+    std::fwrite(positions.data(), sizeof(Vector3), boidCount, file) == boidCount &&
+    std::fwrite(velocities.data(), sizeof(Vector3), boidCount, file) == boidCount;
+
+  return std::fclose(file) == 0 && written == true;
+}
+
+bool
+readSnapshot(
+  const char* path,
+  const std::size_t boidCount,
+  AllocatorArena& allocator,
+  std::size_t& frame,
+  Array <Vector3>& positions,
+  Array <Vector3>& velocities )
+{
+  const auto file = std::fopen(path, "rb");
+
+  if ( file == nullptr )
+    return false;
+
+  const SnapshotHeader expected {};
+  SnapshotHeader header {};
+
+  bool valid =
+    std::fread(&header, sizeof(header), 1, file) == 1 &&
+    std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 &&
+    header.version == expected.version &&
+    header.vectorSize == expected.vectorSize &&
+    header.boidCount == boidCount;
+
+  if ( valid == true )
+  {
+    positions = {allocator, boidCount};
+    velocities = {allocator, boidCount};
+
+    valid =
+      std::fread(positions.data(), sizeof(Vector3), boidCount, file) == boidCount &&
+      std::fread(velocities.data(), sizeof(Vector3), boidCount, file) == boidCount;
+
+    frame = header.frame;
+  }
+
+  std::fclose(file);
+
+  return valid;
+}
+
+std::size_t
+snapshotMemoryRequirement(
+  const std::size_t boidCount )
+{
+  return
+    sizeof(Vector3) * 2 * boidCount +
+    sizeof(std::size_t) * 4;
+}
+
+
+bool
+runValidation(
+  const ValidationConfig& validation )
+{
+  bool passed = validateTiledLoops(validation);
+
+  for ( const auto& scenario : Scenarios )
+  {
+    auto config = scenarioConfig(scenario, validation);
+
+    if ( ReferenceFlock::supports(config) == false )
+    {
+      std::cout << scenario.name << ": not covered by the reference, FAILED\n";
+      passed = false;
+      continue;
+    }
+
+    for ( std::size_t i {}; i < CpuIsaCount; ++i )
+    {
+      config.maxIsa = static_cast <CpuIsa> (i);
+
+      if ( config.maxIsa > selectCpuIsa() )
+        break;
+
+      passed &= validateVariant(scenario, config, validation);
+    }
+
+    passed &= validateGolden(scenario, config, validation);
+  }
+
+  std::cout << (passed ? "validation passed\n" : "validation FAILED\n");
+
+  return passed;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Simulation.hpp"
+#include "Containers.hpp"
+#include "Vector.hpp"
+
+#include <cstddef>
+
+
+//  The flocking model in its plainest form: single-threaded, sums kept
+//  densely per cell and species, every rule evaluated and normalized
+//  exactly. It shares nothing but Vector3 with the kernels, so it can
+//  tell whether an optimized step still computes the same thing.
+//  Covers the configs supports() accepts: fixed uniform grids without
+//  obstacles, flow sources, temporal LOD or species interactions
+struct ReferenceFlock
+{
+  SimulationConfig config {};
+
+  Array <Vector3> position {};
+  Array <Vector3> velocity {};
+  Array <SpeciesId> species {};
+
+//  indexed by cell * speciesCount + species
+  Array <Vector3> cellPosition {};
+  Array <Vector3> cellVelocity {};
+  Array <std::size_t> cellCount {};
+
+
+  ReferenceFlock() = default;
+
+  ReferenceFlock(
+    AllocatorArena&,
+    const SimulationConfig& );
+
+
+//  starts from the simulation's current state
+  void copyState( const Simulation& );
+
+//  starts from the flock a simulation of the config spawns with,
+//  drawn without fast-math, so it doesn't change with the build
+  void spawn();
+
+  void step( const float delta );
+
+
+  static bool supports( const SimulationConfig& );
+
+  static std::size_t memoryRequirement(
+    const SimulationConfig& );
+
+
+private:
+  std::size_t hashCell( const Vector3& ) const;
+
+  void sumCells();
+
+//  group sums of the species around a cell, the stencil
+//  wraps in periodic space and is cut off by walls otherwise
+  void gatherCells(
+    const std::size_t cellId,
+    const SpeciesId,
+    Vector3& positionSum,
+    Vector3& velocitySum,
+    std::size_t& count ) const;
+};
+
+
+//  how far one flock state strays from another
+struct StateError
+{
+  float maxPositionError {};
+  float maxVelocityError {};
+
+//  boid with the largest position error
+  std::size_t worstBoid {};
+
+//  boids beyond either tolerance, over all frames compared
+  std::size_t mismatchCount {};
+};
+
+struct StateTolerance
+{
+  float position {};
+  float velocity {};
+};
+
+//  position errors are measured along the shortest way
+//  around the cube in periodic space
+StateError compareStates(
+  const ArrayView <Vector3>& positions,
+  const ArrayView <Vector3>& velocities,
+  const ArrayView <Vector3>& expectedPositions,
+  const ArrayView <Vector3>& expectedVelocities,
+  const BoundaryMode,
+  const StateTolerance& );
+
+
+//  Golden snapshots are raw dumps of a flock's positions and velocities
+//  after a given frame in the host's byte order, behind a small header
+//  that rejects files of other versions or vector layouts
+bool writeSnapshot(
+  const char* path,
+  const std::size_t frame,
+  const ArrayView <Vector3>& positions,
+  const ArrayView <Vector3>& velocities );
+
+//  false if the file is missing, malformed or holds another boid count,
+//  the arrays are allocated from the arena on success
+bool readSnapshot(
+  const char* path,
+  const std::size_t boidCount,
+  AllocatorArena&,
+  std::size_t& frame,
+  Array <Vector3>& positions,
+  Array <Vector3>& velocities );
+
+std::size_t snapshotMemoryRequirement(
+  const std::size_t boidCount );
+
+
+struct ValidationConfig
+{
+  std::size_t boidCount {8192};
+  std::size_t cellPerAxisCount {16};
+  std::size_t threadCount {3};
+
+  std::size_t frameCount {60};
+  float delta {1.f / 240.f};
+
+  std::uint32_t seed {1};
+
+//  per step between a kernel variant and the reference,
+//  and between a reference and its golden snapshot
+  StateTolerance runTolerance {1e-6f, 1e-4f};
+  StateTolerance goldenTolerance {1e-6f, 1e-5f};
+
+//  Boids whose group hardly differs from themselves, like boids stacked
+//  against a wall, steer by a rule vector close to 0 whose direction
+//  is down to rounding. This share of a run's boid steps may mismatch,
+//  a broken kernel misses on far more
+  float maxMismatchShare {0.01f};
+
+//  null for the golden directory of the source tree
+  const char* goldenDirectory {};
+
+//  writes every reference as its snapshot instead of
+//  comparing it, a missing snapshot fails otherwise
+  bool recordGolden {false};
+};
+
+//  First checks that the thread pool's tiled loops visit every cell of
+//  odd-sized 2D and 3D spaces exactly once. Then steps every scenario
+//  with each kernel variant the host can run, each frame is checked
+//  against a reference step from the same state, and runs each
+//  scenario's reference alone for all frames to compare the result to
+//  its golden snapshot. Prints a line per run, false if a loop misses
+//  cells, a run or reference is out of tolerance or a snapshot is missing
+bool runValidation( const ValidationConfig& );
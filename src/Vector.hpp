@@ -1,5 +1,12 @@
 #pragma once
 
+#include <cmath>
+#include <cstddef>
+
+
+//  Everything here is defined inline, so rule loops see straight-line
+//  arithmetic they can keep in registers and vectorize without LTO
+
 
 struct Vector3
 {
@@ -11,26 +18,630 @@ struct Vector3
 
 
   value_type length() const;
-  value_type length_squared() const;
+  constexpr value_type length_squared() const;
 
   Vector3 normalized() const;
   Vector3 normalized_fast() const;
   value_type distance( const Vector3& ) const;
 
-  value_type dot( const Vector3& ) const;
-  Vector3 cross( const Vector3& ) const;
+  constexpr value_type dot( const Vector3& ) const;
+  constexpr Vector3 cross( const Vector3& ) const;
 };
 
 
-Vector3 operator + ( const Vector3& lhs, const Vector3& rhs );
-Vector3 operator - ( const Vector3& lhs, const Vector3& rhs );
-Vector3 operator * ( const Vector3& lhs, const Vector3::value_type& rhs );
-Vector3 operator / ( const Vector3& lhs, const Vector3::value_type& rhs );
+constexpr Vector3 operator + ( const Vector3& lhs, const Vector3& rhs );
+constexpr Vector3 operator - ( const Vector3& lhs, const Vector3& rhs );
+constexpr Vector3 operator * ( const Vector3& lhs, const Vector3::value_type& rhs );
+constexpr Vector3 operator / ( const Vector3& lhs, const Vector3::value_type& rhs );
+
+
+constexpr Vector3 operator * ( const Vector3::value_type& lhs, const Vector3& rhs );
+
+constexpr Vector3& operator += ( Vector3& lhs, const Vector3& rhs );
+constexpr Vector3& operator -= ( Vector3& lhs, const Vector3& rhs );
+constexpr Vector3& operator *= ( Vector3& lhs, const Vector3::value_type& rhs );
+constexpr Vector3& operator /= ( Vector3& lhs, const Vector3::value_type& rhs );
+
+
+//  Vector3 padded to 16 bytes, so one vector fills one SSE register and
+//  arrays of them load without straddling. w is carried through the
+//  arithmetic like the other lanes and is 0 for directions and positions
+struct alignas(16) Vector4
+{
+  using value_type = float;
+
+  value_type x {};
+  value_type y {};
+  value_type z {};
+  value_type w {};
+
+
+  value_type length() const;
+  constexpr value_type length_squared() const;
+
+  Vector4 normalized() const;
+  value_type distance( const Vector4& ) const;
+
+  constexpr value_type dot( const Vector4& ) const;
+
+//  of the xyz parts, w is 0
+  constexpr Vector4 cross( const Vector4& ) const;
+
+  constexpr Vector3 xyz() const;
+};
+
+constexpr Vector4 toVector4(
+  const Vector3&,
+  const Vector4::value_type w = {} );
+
+
+constexpr Vector4 operator + ( const Vector4& lhs, const Vector4& rhs );
+constexpr Vector4 operator - ( const Vector4& lhs, const Vector4& rhs );
+constexpr Vector4 operator * ( const Vector4& lhs, const Vector4::value_type& rhs );
+constexpr Vector4 operator / ( const Vector4& lhs, const Vector4::value_type& rhs );
+
+
+constexpr Vector4 operator * ( const Vector4::value_type& lhs, const Vector4& rhs );
+
+constexpr Vector4& operator += ( Vector4& lhs, const Vector4& rhs );
+constexpr Vector4& operator -= ( Vector4& lhs, const Vector4& rhs );
+constexpr Vector4& operator *= ( Vector4& lhs, const Vector4::value_type& rhs );
+constexpr Vector4& operator /= ( Vector4& lhs, const Vector4::value_type& rhs );
+
+
+//  Width Vector3s stored component by component. Loops over the lanes
+//  compile to packed instructions of whatever width the target has,
+//  load() and store() convert from and to arrays of Vector3
+template <std::size_t Width>
+struct Vector3Batch
+{
+  using value_type = Vector3::value_type;
+
+  static constexpr std::size_t width {Width};
+
+  value_type x [Width] {};
+  value_type y [Width] {};
+  value_type z [Width] {};
+
+
+  constexpr void load( const Vector3* vectors );
+  constexpr void store( Vector3* vectors ) const;
+
+  constexpr Vector3 get( const std::size_t lane ) const;
+  constexpr void set( const std::size_t lane, const Vector3& );
+
+  constexpr void length_squared( value_type (&lengths) [Width] ) const;
+
+  Vector3Batch normalized() const;
+
+  constexpr void dot(
+    const Vector3Batch&,
+    value_type (&products) [Width] ) const;
+};
+
+using Vector3x4 = Vector3Batch <4>;
+using Vector3x8 = Vector3Batch <8>;
+using Vector3x16 = Vector3Batch <16>;
+
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width> operator + ( const Vector3Batch <Width>& lhs, const Vector3Batch <Width>& rhs );
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width> operator - ( const Vector3Batch <Width>& lhs, const Vector3Batch <Width>& rhs );
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width> operator * ( const Vector3Batch <Width>& lhs, const Vector3::value_type& rhs );
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width> operator / ( const Vector3Batch <Width>& lhs, const Vector3::value_type& rhs );
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width>& operator += ( Vector3Batch <Width>& lhs, const Vector3Batch <Width>& rhs );
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width>& operator -= ( Vector3Batch <Width>& lhs, const Vector3Batch <Width>& rhs );
+
+
+inline Vector3::value_type
+Vector3::length() const
+{
+  return std::sqrt( length_squared() );
+}
+
+constexpr Vector3::value_type
+Vector3::length_squared() const
+{
+  return x * x + y * y + z * z;
+}
+
+inline Vector3
+Vector3::normalized() const
+{
+  const auto len = length();
+
+  if ( len != 0.f )
+    return *this / len;
+
+  return {};
+}
+
+inline Vector3::value_type
+Vector3::distance(
+  const Vector3& other ) const
+{
+  return (other - *this).length();
+}
+
+constexpr Vector3::value_type
+Vector3::dot(
+  const Vector3& other ) const
+{
+  return x * other.x + y * other.y + z * other.z;
+}
+
+constexpr Vector3
+Vector3::cross(
+  const Vector3& other ) const
+{
+  return
+  {
+    y * other.z - z * other.y,
+    z * other.x - x * other.z,
+    x * other.y - y * other.x,
+  };
+}
+
+
+constexpr Vector3
+operator + (
+  const Vector3& lhs,
+  const Vector3& rhs )
+{
+  return
+  {
+    lhs.x + rhs.x,
+    lhs.y + rhs.y,
+    lhs.z + rhs.z,
+  };
+}
+
+constexpr Vector3
+operator - (
+  const Vector3& lhs,
+  const Vector3& rhs )
+{
+  return
+  {
+    lhs.x - rhs.x,
+    lhs.y - rhs.y,
+    lhs.z - rhs.z,
+  };
+}
+
+constexpr Vector3
+operator * (
+  const Vector3& lhs,
+  const Vector3::value_type& rhs )
+{
+  return
+  {
+    lhs.x * rhs,
+    lhs.y * rhs,
+    lhs.z * rhs,
+  };
+}
+
+constexpr Vector3
+operator / (
+  const Vector3& lhs,
+  const Vector3::value_type& rhs )
+{
+  return
+  {
+    lhs.x / rhs,
+    lhs.y / rhs,
+    lhs.z / rhs,
+  };
+}
+
+
+constexpr Vector3
+operator * (
+  const Vector3::value_type& lhs,
+  const Vector3& rhs )
+{
+  return
+  {
+    lhs * rhs.x,
+    lhs * rhs.y,
+    lhs * rhs.z,
+  };
+}
+
+constexpr Vector3&
+operator += (
+  Vector3& lhs,
+  const Vector3& rhs )
+{
+  lhs = lhs + rhs;
+  return lhs;
+}
+
+constexpr Vector3&
+operator -= (
+  Vector3& lhs,
+  const Vector3& rhs )
+{
+  lhs = lhs - rhs;
+  return lhs;
+}
+
+constexpr Vector3&
+operator *= (
+  Vector3& lhs,
+  const Vector3::value_type& rhs )
+{
+  lhs = lhs * rhs;
+  return lhs;
+}
+
+constexpr Vector3&
+operator /= (
+  Vector3& lhs,
+  const Vector3::value_type& rhs )
+{
+  lhs = lhs / rhs;
+  return lhs;
+}
+
+
+inline Vector4::value_type
+Vector4::length() const
+{
+  return std::sqrt( length_squared() );
+}
+
+constexpr Vector4::value_type
+Vector4::length_squared() const
+{
+  return x * x + y * y + z * z + w * w;
+}
+
+inline Vector4
+Vector4::normalized() const
+{
+  const auto len = length();
+
+  if ( len != 0.f )
+    return *this / len;
+
+  return {};
+}
+
+inline Vector4::value_type
+Vector4::distance(
+  const Vector4& other ) const
+{
+  return (other - *this).length();
+}
+
+constexpr Vector4::value_type
+Vector4::dot(
+  const Vector4& other ) const
+{
+  return x * other.x + y * other.y + z * other.z + w * other.w;
+}
+
+constexpr Vector4
+Vector4::cross(
+  const Vector4& other ) const
+{
+  return
+  {
+    y * other.z - z * other.y,
+    z * other.x - x * other.z,
+    x * other.y - y * other.x,
+    0.f,
+  };
+}
+
+constexpr Vector3
+Vector4::xyz() const
+{
+  return {x, y, z};
+}
+
+constexpr Vector4
+toVector4(
+  const Vector3& vector,
+  const Vector4::value_type w )
+{
+  return {vector.x, vector.y, vector.z, w};
+}
+
+
+constexpr Vector4
+operator + (
+  const Vector4& lhs,
+  const Vector4& rhs )
+{
+  return
+  {
+    lhs.x + rhs.x,
+    lhs.y + rhs.y,
+    lhs.z + rhs.z,
+    lhs.w + rhs.w,
+  };
+}
+
+constexpr Vector4
+operator - (
+  const Vector4& lhs,
+  const Vector4& rhs )
+{
+  return
+  {
+    lhs.x - rhs.x,
+    lhs.y - rhs.y,
+    lhs.z - rhs.z,
+    lhs.w - rhs.w,
+  };
+}
+
+constexpr Vector4
+operator * (
+  const Vector4& lhs,
+  const Vector4::value_type& rhs )
+{
+  return
+  {
+    lhs.x * rhs,
+    lhs.y * rhs,
+    lhs.z * rhs,
+    lhs.w * rhs,
+  };
+}
+
+constexpr Vector4
+operator / (
+  const Vector4& lhs,
+  const Vector4::value_type& rhs )
+{
+  return
+  {
+    lhs.x / rhs,
+    lhs.y / rhs,
+    lhs.z / rhs,
+    lhs.w / rhs,
+  };
+}
+
+
+constexpr Vector4
+operator * (
+  const Vector4::value_type& lhs,
+  const Vector4& rhs )
+{
+  return rhs * lhs;
+}
+
+constexpr Vector4&
+operator += (
+  Vector4& lhs,
+  const Vector4& rhs )
+{
+  lhs = lhs + rhs;
+  return lhs;
+}
+
+constexpr Vector4&
+operator -= (
+  Vector4& lhs,
+  const Vector4& rhs )
+{
+  lhs = lhs - rhs;
+  return lhs;
+}
+
+constexpr Vector4&
+operator *= (
+  Vector4& lhs,
+  const Vector4::value_type& rhs )
+{
+  lhs = lhs * rhs;
+  return lhs;
+}
+
+constexpr Vector4&
+operator /= (
+  Vector4& lhs,
+  const Vector4::value_type& rhs )
+{
+  lhs = lhs / rhs;
+  return lhs;
+}
+
+
+template <std::size_t Width>
+constexpr void
+Vector3Batch <Width>::load(
+  const Vector3* vectors )
+{
+  for ( std::size_t i {}; i < Width; ++i )
+  {
+    x[i] = vectors[i].x;
+    y[i] = vectors[i].y;
+    z[i] = vectors[i].z;
+  }
+}
+
+template <std::size_t Width>
+constexpr void
+Vector3Batch <Width>::store(
+  Vector3* vectors ) const
+{
+  for ( std::size_t i {}; i < Width; ++i )
+    vectors[i] = {x[i], y[i], z[i]};
+}
+
+template <std::size_t Width>
+constexpr Vector3
+Vector3Batch <Width>::get(
+  const std::size_t lane ) const
+{
+  return {x[lane], y[lane], z[lane]};
+}
+
+template <std::size_t Width>
+constexpr void
+Vector3Batch <Width>::set(
+  const std::size_t lane,
+  const Vector3& vector )
+{
+  x[lane] = vector.x;
+  y[lane] = vector.y;
+  z[lane] = vector.z;
+}
+
+template <std::size_t Width>
+constexpr void
+Vector3Batch <Width>::length_squared(
+  value_type (&lengths) [Width] ) const
+{
+  for ( std::size_t i {}; i < Width; ++i )
+    lengths[i] = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+}
+
+template <std::size_t Width>
+Vector3Batch <Width>
+Vector3Batch <Width>::normalized() const
+{
+  value_type scales [Width] {};
+
+  length_squared(scales);
+
+//  selects instead of branching, so the lanes stay independent
+  for ( std::size_t i {}; i < Width; ++i )
+    scales[i] = scales[i] != 0.f
+      ? 1.f / std::sqrt(scales[i])
+      : 0.f;
+
+  Vector3Batch result {};
+
+  for ( std::size_t i {}; i < Width; ++i )
+  {
+    result.x[i] = x[i] * scales[i];
+    result.y[i] = y[i] * scales[i];
+    result.z[i] = z[i] * scales[i];
+  }
+
+  return result;
+}
+
+template <std::size_t Width>
+constexpr void
+Vector3Batch <Width>::dot(
+  const Vector3Batch& other,
+  value_type (&products) [Width] ) const
+{
+  for ( std::size_t i {}; i < Width; ++i )
+    products[i] = x[i] * other.x[i] + y[i] * other.y[i] + z[i] * other.z[i];
+}
+
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width>
+operator + (
+  const Vector3Batch <Width>& lhs,
+  const Vector3Batch <Width>& rhs )
+{
+  auto result = lhs;
+  result += rhs;
+
+  return result;
+}
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width>
+operator - (
+  const Vector3Batch <Width>& lhs,
+  const Vector3Batch <Width>& rhs )
+{
+  auto result = lhs;
+  result -= rhs;
+
+  return result;
+}
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width>
+operator * (
+  const Vector3Batch <Width>& lhs,
+  const Vector3::value_type& rhs )
+{
+  auto result = lhs;
+
+  for ( std::size_t i {}; i < Width; ++i )
+  {
+    result.x[i] *= rhs;
+    result.y[i] *= rhs;
+    result.z[i] *= rhs;
+  }
+
+  return result;
+}
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width>
+operator / (
+  const Vector3Batch <Width>& lhs,
+  const Vector3::value_type& rhs )
+{
+  auto result = lhs;
+
+  for ( std::size_t i {}; i < Width; ++i )
+  {
+    result.x[i] /= rhs;
+    result.y[i] /= rhs;
+    result.z[i] /= rhs;
+  }
+
+  return result;
+}
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width>&
+operator += (
+  Vector3Batch <Width>& lhs,
+  const Vector3Batch <Width>& rhs )
+{
+  for ( std::size_t i {}; i < Width; ++i )
+  {
+    lhs.x[i] += rhs.x[i];
+    lhs.y[i] += rhs.y[i];
+    lhs.z[i] += rhs.z[i];
+  }
+
+  return lhs;
+}
+
+template <std::size_t Width>
+constexpr Vector3Batch <Width>&
+operator -= (
+  Vector3Batch <Width>& lhs,
+  const Vector3Batch <Width>& rhs )
+{
+  for ( std::size_t i {}; i < Width; ++i )
+  {
+    lhs.x[i] -= rhs.x[i];
+    lhs.y[i] -= rhs.y[i];
+    lhs.z[i] -= rhs.z[i];
+  }
 
+  return lhs;
+}
 
-Vector3 operator * ( const Vector3::value_type& lhs, const Vector3& rhs );
 
-Vector3& operator += ( Vector3& lhs, const Vector3& rhs );
-Vector3& operator -= ( Vector3& lhs, const Vector3& rhs );
-Vector3& operator *= ( Vector3& lhs, const Vector3::value_type& rhs );
-Vector3& operator /= ( Vector3& lhs, const Vector3::value_type& rhs );
+//  normalized_fast() lives with the rest of the approximate math
+#include "FastMath.hpp"
@@ -1,620 +1,337 @@
-#include "Allocators.hpp"
-#include "Containers.hpp"
+#include "Simulation.hpp"
+#include "Obstacles.hpp"
+#include "FlowField.hpp"
+#include "Octree.hpp"
+#include "FramePipeline.hpp"
+#include "Domain.hpp"
+#include "FastMath.hpp"
+#include "Validation.hpp"
+#include "Benchmark.hpp"
+#include "Realtime.hpp"
+#include "QueueCheck.hpp"
+#include "Ensemble.hpp"
 #include "Vector.hpp"
-#include "ThreadPool.hpp"
 #include "ThreadAffinity.hpp"
 #include "PerformanceCounter.hpp"
 
-#include <cassert>
-#include <chrono>
-
+#include <array>
+#include <cmath>
 #include <random>
+#include <string>
 #include <iostream>
-#include <functional>
-
-
-struct BoidRuleset
-{
-  struct
-  {
-    float alignment {0.1f};
-    float coherence {0.1f};
-    float separation {0.1f};
-
-  } weights {};
-
-  float obstacleAvoidanceDistance {0.15f};
-  float maxSpeed {0.1f};
-};
-
-struct BoidData
-{
-  using FloatType = Vector3::value_type;
-
-
-  Array <std::size_t> cellId {};
-  Array <std::size_t> boidCount {};
-
-  Array <Vector3> averagePosition {};
-  Array <Vector3> averageVelocity {};
-
-  Array <Vector3> obstacleAvoidance {};
-  Array <Vector3> alignment {};
-  Array <Vector3> coherence {};
-  Array <Vector3> separation {};
-};
-
-
-std::size_t
-hashPos(
-  const Vector3& pos,
-  const std::size_t cellCount )
-{
-  return
-    static_cast <std::size_t> (pos.x * cellCount) +
-    static_cast <std::size_t> (pos.y * cellCount) * cellCount +
-    static_cast <std::size_t> (pos.z * cellCount) * cellCount * cellCount;
-}
-
-
-Vector3::value_type
-getAvoidance(
-  const Vector3::value_type coordinate,
-  const Vector3::value_type margin )
-{
-  if ( coordinate > 1 - margin )
-    return -1;
-
-  if ( coordinate < margin )
-    return 1;
-
-  return {};
-}
-
-using Clock = std::chrono::high_resolution_clock;
-
 
-namespace
-{
-enum PerfMarker : size_t
-{
-  ResetTask,
-  HashPosTask,
-  Summing,
-  RulesCalc,
-  Transform,
-  Total,
-
-  PositionSumTask,
-  VelocitySumTask,
-  BoidCountSumTask,
-
-  ObstacleAvoidanceTask,
-  AlignmentTask,
-  CoherenceTask,
-  SeparationTask,
-
-  TransformBoidsTask,
-
-  Count,
-};
-
-TimePerfCounter timeCounter [PerfMarker::Count] {};
-CyclePerfCounter cycleCounter [PerfMarker::Count] {};
-}
-
-void
-printElapsedTime(
-  const Clock::time_point& from,
-  const Clock::time_point& to,
-  const std::string& name )
-{
-
-  const auto elapsedUs =
-    std::chrono::duration_cast <std::chrono::microseconds> (
-      to - from).count();
-
-  std::cout << name + " took " + std::to_string(elapsedUs) + "us\n";
-}
 
 void
 printElapsedTime(
-  const PerfMarker markerId,
+  const Simulation& simulation,
+  const Simulation::PerfMarker markerId,
   const std::string& name )
 {
 
   const auto elapsedUs =
-    timeCounter[markerId].average.count();
+    simulation.timeCounter[markerId].average.count();
 
   std::cout <<
     name + " took " +
     std::to_string(elapsedUs) + " us\n";
 }
 
-int
-main(
-  int argc,
-  char* argv[] )
+//  scattered obstacles of every type, the same scene for the same count
+template <std::size_t ObstacleCount>
+void
+buildDemoObstacles(
+  std::array <Obstacle, ObstacleCount>& obstacles )
 {
-  const std::size_t threadCount {3};
-  const std::size_t boidCount {400'000};
-  const std::size_t cellPerAxisCount {100};
-  const std::size_t cellCount =
-    std::pow(cellPerAxisCount, std::size_t{3});
-
-  const auto boidMemory =
-    sizeof(Vector3) +
-    sizeof(Vector3) +
-    sizeof(std::size_t) +
-    sizeof(std::size_t) +
-    sizeof(Vector3) +
-    sizeof(Vector3) +
-    sizeof(Vector3) +
-    sizeof(Vector3) +
-    sizeof(Vector3) +
-    sizeof(Vector3);
-
-  const auto cellMemory =
-    sizeof(std::size_t);
-//    sizeof(std::atomic_size_t);
-
-
-  AllocatorArena allocator {};
-  allocator.reserve(
-    sizeof(ThreadPool::ThreadEntry) * threadCount +
-    boidMemory * boidCount +
-    cellMemory * cellCount +
-    sizeof(std::size_t) * 12 );
-
+  std::minstd_rand0 sceneEngine {ObstacleCount};
+  std::uniform_real_distribution sceneDist(0.f, 1.f);
 
+  for ( std::size_t i {}; i < obstacles.size(); ++i )
   {
-    auto mask = initAffinityMask();
-    addCpuToAffinityMask(mask, 0);
-    setThreadAffinity(mask);
-
+    auto& obstacle = obstacles[i];
 
-    ThreadPool threadPool {};
-    threadPool.init(
-      allocator, threadCount, 2 );
-
-
-    BoidData boids
+    const Vector3 center
     {
-      {allocator, boidCount},
-      {allocator, boidCount},
-      {allocator, boidCount},
-      {allocator, boidCount},
-      {allocator, boidCount},
-      {allocator, boidCount},
-      {allocator, boidCount},
-      {allocator, boidCount},
-      {allocator, boidCount},
-      {allocator, boidCount},
+      sceneDist(sceneEngine),
+      sceneDist(sceneEngine),
+      sceneDist(sceneEngine),
     };
 
-    Array <std::size_t> cells {allocator, cellCount};
-
-    BoidRuleset rules {};
-
-    std::random_device rd {};
-    std::uniform_real_distribution dist(0.f, 1.f);
-    std::minstd_rand0 engine {rd()};
-
-    const auto posInitTask =
-    [&boids, &dist, &engine] ( const std::size_t rangeStart, const std::size_t rangeEnd )
+    const Vector3 extent
     {
-      for ( std::size_t i = rangeStart; i < rangeEnd; ++i )
-      {
-        boids.position[i] = { dist(engine), dist(engine), dist(engine) };
-//        boids.velocity[i] = { dist(engine), dist(engine), dist(engine) };
-      }
+      sceneDist(sceneEngine) * 0.02f,
+      sceneDist(sceneEngine) * 0.02f,
+      sceneDist(sceneEngine) * 0.02f,
     };
 
-    threadPool.parallel_for(posInitTask, boidCount);
-    threadPool.waitForTasks();
-
-
-    std::cout << "start\n";
+    obstacle.type = static_cast <Obstacle::Type> (i % 3);
+    obstacle.radius = 0.005f + sceneDist(sceneEngine) * 0.01f;
 
-    const std::size_t frameCount {600};
-
-    for ( std::size_t frame {}; frame < frameCount; ++frame )
+    switch (obstacle.type)
     {
-      const float delta = std::fmod(dist(rd), 5.f / frameCount);
-
-      PERF_TIME_BEGIN(PerfMarker::Total);
-      PERF_TIME_BEGIN_COPY(PerfMarker::ResetTask, PerfMarker::Total);
-
-      const auto resetCellsTask =
-      [&cells, boidCount] ( const std::size_t rangeStart, const std::size_t rangeEnd )
-      {
-        std::fill_n(
-          cells.data() + rangeStart,
-          rangeEnd - rangeStart,
-          boidCount );
-      };
-
-      const auto resetAveragePositionTask =
-      [&boids] ( const std::size_t rangeStart, const std::size_t rangeEnd )
-      {
-        for ( size_t i = rangeStart; i < rangeEnd; ++i )
-          boids.averagePosition[i] = {};
-      };
-
-      const auto resetAverageVelocityTask =
-      [&boids] ( const std::size_t rangeStart, const std::size_t rangeEnd )
-      {
-        for ( size_t i = rangeStart; i < rangeEnd; ++i )
-          boids.averageVelocity[i] = {};
-      };
-
-      const auto resetBoidCountTask =
-      [&boids] ( const std::size_t rangeStart, const std::size_t rangeEnd )
-      {
-        for ( size_t i = rangeStart; i < rangeEnd; ++i )
-          boids.boidCount[i] = {};
-      };
-
-
-      threadPool.push(
-      [resetAveragePositionTask, boidCount] ()
-      {
-        resetAveragePositionTask(0, boidCount);
-      });
-
-      threadPool.push(
-      [resetAverageVelocityTask, boidCount] ()
-      {
-        resetAverageVelocityTask(0, boidCount);
-      });
-
-      threadPool.push(
-      [resetBoidCountTask, boidCount] ()
-      {
-        resetBoidCountTask(0, boidCount);
-      });
-
-//      threadPool.parallel_for(resetCellsTask, cellCount, threadCount - 3);
-
-      resetCellsTask(0, cellCount);
-
-      threadPool.waitForTasks();
-
+      case Obstacle::Type::Sphere:
+        obstacle.a = center;
+        break;
+
+      case Obstacle::Type::Capsule:
+        obstacle.a = center - extent;
+        obstacle.b = center + extent;
+        break;
+
+      case Obstacle::Type::Box:
+        obstacle.a = center - extent;
+        obstacle.b = center + extent;
+        break;
+    }
+  }
+}
 
-      PERF_TIME_END(PerfMarker::ResetTask);
-      PERF_TIME_BEGIN(PerfMarker::HashPosTask);
+//  the predator is last and moved every frame, see demoPredator()
+const FlowSource DemoFlowSources []
+{
+  {
+    {0.5f, 0.5f, 0.5f}, {1.f, 0.f, 0.f},
+    0.5f, 0.05f,
+    FlowSource::Type::Wind, true,
+  },
+  {
+    {0.4f, 0.4f, 0.4f}, {0.6f, 0.6f, 0.6f},
+    0.1f, 1.f,
+    FlowSource::Type::NoFly, true,
+  },
+  {
+    {0.25f, 0.75f, 0.5f}, {},
+    0.3f, 0.2f,
+    FlowSource::Type::Attractor, true,
+  },
+  {
+    {0.5f, 0.5f, 0.8f}, {},
+    0.2f, 1.f,
+    FlowSource::Type::Repulsor, false,
+  },
+};
 
+constexpr std::size_t DemoPredatorSourceId {std::size(DemoFlowSources) - 1};
 
-      const auto hashPosTask =
-      [&boids, &cells] ( const std::size_t rangeStart, const std::size_t rangeEnd )
-      {
-        for ( std::size_t i = rangeStart; i < rangeEnd; ++i )
-        {
-          const auto& boidPosition = boids.position[i];
+//  circles above the flock once every frameCount frames
+FlowSource
+demoPredator(
+  const std::size_t frame,
+  const std::size_t frameCount )
+{
+  auto predator = DemoFlowSources[DemoPredatorSourceId];
 
-          const auto cellId = hashPos(
-            boidPosition, cellPerAxisCount );
+  const auto angle = 6.2831853f * frame / frameCount;
 
-          boids.cellId[i] = cellId;
+  predator.a =
+  {
+    0.5f + 0.3f * std::cos(angle),
+    0.5f + 0.3f * std::sin(angle),
+    0.8f,
+  };
 
-          cells[cellId] = std::min(i, cells[cellId]);
-        }
-      };
+  return predator;
+}
 
-      hashPosTask(0, boidCount);
-      //    threadPool.parallel_for(hashPosTask, boidCount);
-      //    threadPool.waitForTasks();
 
-      PERF_TIME_END(PerfMarker::HashPosTask);
-      PERF_TIME_BEGIN(PerfMarker::Summing);
+int
+main(
+  int argc,
+  char* argv[] )
+{
+  SimulationConfig config {};
 
-      const auto averagePositionSumTask =
-      [&boids, &cells]
-      {
-        PERF_TIME_BEGIN(PerfMarker::PositionSumTask);
+//  splits the cube into x slabs simulated by separate processes which
+//  exchange halo boids and migrants through shared memory, the halo is
+//  stencilRadius cells thick. 0 runs the single process simulation
+  const std::size_t domainRankCount {0};
 
-        for ( std::size_t i {}; i < boidCount; ++i )
-        {
-          const auto cellId = cells[boids.cellId[i]];
+//  prints how far approximate normalization strays from the exact one
+//  instead of simulating
+  const bool measureNormalization {false};
 
-          const auto& boidPosition = boids.position[i];
+  if ( measureNormalization == true )
+  {
+    const auto error = measureNormalizeError(100'000);
 
-          boids.averagePosition[cellId] += boidPosition;
-        }
+    std::cout <<
+      "normalize error over " << error.sampleCount << " samples" <<
+      ": max " << error.maxError <<
+      ", mean " << error.meanError <<
+      ", max length error " << error.maxLengthError << "\n";
 
-        PERF_TIME_END(PerfMarker::PositionSumTask);
-      };
+    return 0;
+  }
 
-      const auto averageVelocitySumTask =
-      [&boids, &cells]
-      {
-        PERF_TIME_BEGIN(PerfMarker::VelocitySumTask);
+//  steps small seeded flocks with every kernel variant the host runs
+//  next to the scalar reference and compares them boid by boid, then
+//  checks the references against their golden snapshots, see
+//  ValidationConfig. Fails the process on any mismatch
+  const bool validateKernels {false};
 
-        for ( std::size_t i {}; i < boidCount; ++i )
-        {
-          const auto cellId = cells[boids.cellId[i]];
+  if ( validateKernels == true )
+    return runValidation(ValidationConfig{}) ? 0 : 1;
 
-          const auto& boidVelocity = boids.velocity[i];
+//  pushes items through the lock-free rings of Containers.hpp from
+//  every mix of producer and consumer threads, then prints their
+//  throughput, see QueueCheckConfig. Fails the process on an item
+//  lost, duplicated or reordered
+  const bool checkQueues {false};
 
-          boids.averageVelocity[cellId] += boidVelocity;
-        }
+  if ( checkQueues == true )
+    return runQueueChecks(QueueCheckConfig{});
 
-        PERF_TIME_END(PerfMarker::VelocitySumTask);
-      };
+  if ( domainRankCount > 0 )
+  {
+    if ( config.boundary != BoundaryMode::Bounded ||
+         config.spatialIndex != SpatialIndex::Grid ||
+         config.speciesCount != 1 )
+    {
+      std::cout << "domains are slabs of a bounded uniform grid of one species\n";
+      return 1;
+    }
 
-      const auto boidCountSumTask =
-      [&boids, &cells] ()
-      {
-        PERF_TIME_BEGIN(PerfMarker::BoidCountSumTask);
+    DomainConfig domainConfig {};
+    domainConfig.boidCount = config.boidCount;
+    domainConfig.cellsPerAxis = config.cellPerAxisCount;
+    domainConfig.haloRadius = config.stencilRadius;
+    domainConfig.ruleset = config.ruleset;
+    domainConfig.frameCount = config.frameCount;
+    domainConfig.delta = 2.5f / config.frameCount;
 
-        for ( std::size_t i {}; i < boidCount; ++i )
-        {
-          const auto cellId = cells[boids.cellId[i]];
+    return runDomainProcesses(domainConfig, domainRankCount);
+  }
 
-          boids.boidCount[cellId] += 1;
-        }
 
-        PERF_TIME_END(PerfMarker::BoidCountSumTask);
-      };
+  auto mask = initAffinityMask();
+  addCpuToAffinityMask(mask, 0);
+  setThreadAffinity(mask);
 
-      threadPool.push(averagePositionSumTask);
-      threadPool.push(averageVelocitySumTask);
-      boidCountSumTask();
 
-      threadPool.waitForTasks();
+//  times fixed scenarios repeatedly and compares every stage against
+//  the host's baseline, see BenchmarkConfig. Fails the process on a
+//  significant slowdown
+  const bool checkPerformance {false};
 
+  if ( checkPerformance == true )
+    return runBenchmarks(BenchmarkConfig{});
 
-      PERF_TIME_END(PerfMarker::Summing);
-      PERF_TIME_BEGIN(PerfMarker::RulesCalc);
+//  presents the flock at a fixed frame rate with fixed steps and
+//  interpolation, lowering quality to hold the frame budget, see
+//  RealtimeConfig. Fails the process on a missed deadline
+  const bool runInRealtime {false};
 
-      const auto calcObstacleAvoidanceTask =
-      [&boids, &rules] ()
-      {
-        PERF_TIME_BEGIN(PerfMarker::ObstacleAvoidanceTask);
+  if ( runInRealtime == true )
+    return runRealtime(config, RealtimeConfig{});
 
-        for ( std::size_t i {}; i < boidCount; ++i )
-        {
-          const auto& position = boids.position[i];
+//  simulates many small flocks with sampled rule weights, one per
+//  thread at a time, and writes a line of results per flock, see
+//  EnsembleConfig. Fails the process if a flock couldn't run
+  const bool runParameterStudy {false};
 
-          boids.obstacleAvoidance[i] =
-          {
-            getAvoidance(position.x, rules.obstacleAvoidanceDistance),
-            getAvoidance(position.y, rules.obstacleAvoidanceDistance),
-            getAvoidance(position.z, rules.obstacleAvoidanceDistance)
-          };
-        }
+  if ( runParameterStudy == true )
+    return runEnsemble(EnsembleConfig{});
 
-        PERF_TIME_END(PerfMarker::ObstacleAvoidanceTask);
-      };
 
-      const auto calcAlignmentTask =
-      [&boids, &cells, &weights = rules.weights] ()
-      {
-        PERF_TIME_BEGIN(PerfMarker::AlignmentTask);
+//  random obstacles and a few flow sources around
+//  the flock, one of them a predator circling it
+  const std::size_t demoObstacleCount {0};
+  const bool addDemoFlowSources {false};
 
-        for ( std::size_t i {}; i < boidCount; ++i )
-        {
-          const auto cellId = cells[boids.cellId[i]];
+  std::array <Obstacle, demoObstacleCount> demoObstacles {};
+  buildDemoObstacles(demoObstacles);
 
-          const auto neighborCount = boids.boidCount[cellId];
+  config.obstacles = {demoObstacles.data(), demoObstacles.size()};
 
-//          assert(neighborCount > 0);
+  if ( addDemoFlowSources == true )
+    config.flowSources = {DemoFlowSources, std::size(DemoFlowSources)};
 
-          const auto& velocity = boids.velocity[i];
 
-          const auto& averageVelocity =
-            boids.averageVelocity[cellId];
+  Simulation simulation {};
 
-          const auto alignment =
-            averageVelocity / neighborCount - velocity;
+  if ( simulation.init(config) == false )
+  {
+    std::cout << "invalid simulation config or out of memory\n";
+    return 1;
+  }
 
-          boids.alignment[i] =
-            weights.alignment *
-            alignment.normalized();
 
-          assert(boids.alignment[i].x >= -1.f);
-          assert(boids.alignment[i].y >= -1.f);
-          assert(boids.alignment[i].z >= -1.f);
-          assert(boids.alignment[i].x <= 1.f);
-          assert(boids.alignment[i].y <= 1.f);
-          assert(boids.alignment[i].z <= 1.f);
-        }
+  std::random_device rd {};
+  std::uniform_real_distribution dist(0.f, 1.f);
 
-        PERF_TIME_END(PerfMarker::AlignmentTask);
-      };
+  std::cout <<
+    "kernels " << cpuIsaName(simulation.isa()) <<
+    ", features " << simulation.features() << "\n";
 
-      const auto calcCoherenceTask =
-      [&boids, &cells, &weights = rules.weights] ()
-      {
-        PERF_TIME_BEGIN(PerfMarker::CoherenceTask);
+  std::cout << "start\n";
 
-        for ( std::size_t i {}; i < boidCount; ++i )
-        {
-          const auto cellId = cells[boids.cellId[i]];
-          const auto neighborCount = boids.boidCount[cellId];
+  for ( std::size_t frame {}; frame < config.frameCount; ++frame )
+  {
+    const float delta = std::fmod(dist(rd), 5.f / config.frameCount);
 
-//          assert(neighborCount > 0);
+    if ( addDemoFlowSources == true )
+      simulation.setFlowSource(
+        DemoPredatorSourceId, demoPredator(frame, config.frameCount) );
 
-          const auto& position = boids.position[i];
+    simulation.step(delta);
+  }
 
-          const auto& averagePosition =
-            boids.averagePosition[cellId];
+  simulation.drain();
 
-          const auto coherence =
-            averagePosition / neighborCount - position;
 
-          boids.coherence[i] =
-            weights.coherence *
-            coherence.normalized();
+  const auto positions = simulation.positions();
+  const auto velocities = simulation.velocities();
 
-          assert(boids.coherence[i].x >= -1.f);
-          assert(boids.coherence[i].y >= -1.f);
-          assert(boids.coherence[i].z >= -1.f);
-          assert(boids.coherence[i].x <= 1.f);
-          assert(boids.coherence[i].y <= 1.f);
-          assert(boids.coherence[i].z <= 1.f);
-        }
-
-        PERF_TIME_END(PerfMarker::CoherenceTask);
-      };
-
-      const auto calcSeparationTask =
-      [&boids, &cells, &weights = rules.weights] ()
-      {
-        PERF_TIME_BEGIN(PerfMarker::SeparationTask);
-
-        for ( std::size_t i {}; i < boidCount; ++i )
-        {
-          const auto cellId = cells[boids.cellId[i]];
-          const auto neighborCount = boids.boidCount[cellId];
-
-//          assert(neighborCount > 0);
-
-          const auto& position = boids.position[i];
-
-          const auto& averagePosition =
-            boids.averagePosition[cellId];
-
-          const auto separation =
-            position - averagePosition / neighborCount;
-
-          boids.separation[i] =
-//            averagePosition;
-            weights.separation *
-            separation.normalized();
+  Vector3 pos {};
+  Vector3 vel {};
 
-          assert(boids.separation[i].x >= -1.f);
-          assert(boids.separation[i].y >= -1.f);
-          assert(boids.separation[i].z >= -1.f);
-          assert(boids.separation[i].x <= 1.f);
-          assert(boids.separation[i].y <= 1.f);
-          assert(boids.separation[i].z <= 1.f);
-        }
+  for ( std::size_t i {}; i < positions.length(); ++i )
+  {
+    pos += positions[i];
+    vel += velocities[i];
+  }
 
-        PERF_TIME_END(PerfMarker::SeparationTask);
-      };
+  pos /= positions.length();
+  vel /= velocities.length();
 
-      const auto transformBoidsTask =
-      [&boids, &rules, delta] ( const std::size_t rangeStart, const std::size_t rangeEnd )
-      {
-//        PERF_TIME_BEGIN(PerfMarker::TransformBoidsTask);
-
-        for ( std::size_t i = rangeStart; i < rangeEnd; ++i )
-        {
-          auto& velocity = boids.velocity[i];
-          auto& position = boids.position[i];
-
-          const auto& obstacleAvoidance = boids.obstacleAvoidance[i];
-          const auto& alignment = boids.alignment[i];
-          const auto& coherence = boids.coherence[i];
-          const auto& separation = boids.separation[i];
-
-          const auto heading =
-            alignment + coherence + separation;
-
-          const auto desiredVelocity =
-            obstacleAvoidance.length_squared() > 0.f
-              ? obstacleAvoidance.normalized()
-              : heading.normalized();
-
-          const auto prevVelocity = velocity;
-
-          velocity =
-            (velocity + (desiredVelocity - velocity) * delta).normalized();
-
-          assert(velocity.x >= -1.f);
-          assert(velocity.y >= -1.f);
-          assert(velocity.z >= -1.f);
-          assert(velocity.x <= 1.f);
-          assert(velocity.y <= 1.f);
-          assert(velocity.z <= 1.f);
-
-          assert(prevVelocity.x >= -1.f);
-          assert(prevVelocity.y >= -1.f);
-          assert(prevVelocity.z >= -1.f);
-          assert(prevVelocity.x <= 1.f);
-          assert(prevVelocity.y <= 1.f);
-          assert(prevVelocity.z <= 1.f);
-
-          position += velocity * rules.maxSpeed * delta;
-
-          assert(position.x >= 0.f);
-          assert(position.y >= 0.f);
-          assert(position.z >= 0.f);
-          assert(position.x <= 1.f);
-          assert(position.y <= 1.f);
-          assert(position.z <= 1.f);
-          continue;
-
-          boids.position[i] =
-          {
-            std::fmod(boids.position[i].x + velocity.x * delta, 1.f),
-            std::fmod(boids.position[i].y + velocity.y * delta, 1.f),
-            std::fmod(boids.position[i].z + velocity.z * delta, 1.f),
-          };
-        }
-
-//        PERF_TIME_END(PerfMarker::TransformBoidsTask);
-      };
-
-      threadPool.push(calcAlignmentTask);
-      threadPool.push(calcCoherenceTask);
-      threadPool.push(calcSeparationTask);
-      calcObstacleAvoidanceTask();
-
-      threadPool.waitForTasks();
-
-      PERF_TIME_END(PerfMarker::RulesCalc);
-      PERF_TIME_BEGIN(PerfMarker::Transform);
-
-//      transformBoidsTask(0, boidCount);
-      threadPool.parallel_for(transformBoidsTask, boidCount);
-      threadPool.waitForTasks();
-
-      PERF_TIME_END(PerfMarker::Transform);
-      PERF_TIME_END(PerfMarker::Total);
-
-      for ( size_t i {}; i < PerfMarker::Count; ++i )
-        timeCounter[i].update(frameCount);
-    }
+  std::cout << "boid pos " << pos.x << ", " << pos.y << ", " << pos.z << "\n";
+  std::cout << "boid vel " << vel.x << ", " << vel.y << ", " << vel.z << "\n";
 
-    Vector3 pos {};
-    Vector3 vel {};
+  if ( config.adaptiveGrid == true )
+    std::cout << "grid cells per axis " << simulation.gridCellsPerAxis() << "\n";
 
-    for ( std::size_t i {}; i < boidCount; ++i )
-    {
-      pos += boids.position[i];
-      vel += boids.velocity[i];
-    }
+  const auto records = simulation.records();
 
-    pos /= boidCount;
-    vel /= boidCount;
-
-    std::cout << "boid pos " << pos.x << ", " << pos.y << ", " << pos.z << "\n";
-    std::cout << "boid vel " << vel.x << ", " << vel.y << ", " << vel.z << "\n";
-
-    printElapsedTime(PerfMarker::ResetTask, "reinit");
-    printElapsedTime(PerfMarker::HashPosTask, "HashPosTask");
-    printElapsedTime(PerfMarker::Summing, "Summing");
-    printElapsedTime(PerfMarker::RulesCalc, "RulesCalc");
-    printElapsedTime(PerfMarker::Transform, "Transform");
-    printElapsedTime(PerfMarker::Total, "Total");
-    std::cout << "\n";
-    printElapsedTime(PerfMarker::PositionSumTask, "PositionSumTask");
-    printElapsedTime(PerfMarker::VelocitySumTask, "VelocitySumTask");
-    printElapsedTime(PerfMarker::BoidCountSumTask, "BoidCountSumTask");
-
-    printElapsedTime(PerfMarker::ObstacleAvoidanceTask, "ObstacleAvoidanceTask");
-    printElapsedTime(PerfMarker::AlignmentTask, "AlignmentTask");
-    printElapsedTime(PerfMarker::CoherenceTask, "CoherenceTask");
-    printElapsedTime(PerfMarker::SeparationTask, "SeparationTask");
-
-    threadPool.deinit();
+  if ( records.length() > 0 )
+  {
+    const auto& last =
+      records[records.length() - 1];
+
+    std::cout <<
+      "recorded frame " << last.frame <<
+      " centroid " << last.centroid.x << ", " << last.centroid.y << ", " << last.centroid.z <<
+      " bounds " << last.boundsMin.x << ", " << last.boundsMin.y << ", " << last.boundsMin.z <<
+      " .. " << last.boundsMax.x << ", " << last.boundsMax.y << ", " << last.boundsMax.z << "\n";
   }
 
-
-  allocator.free();
+  if ( config.spatialIndex == SpatialIndex::Octree )
+    std::cout <<
+      "octree leaves " << simulation.octree().leafCount <<
+      ", max depth " << simulation.octree().maxLeafDepth << "\n";
+
+  printElapsedTime(simulation, Simulation::PerfMarker::ResetTask, "reinit");
+  printElapsedTime(simulation, Simulation::PerfMarker::HashPosTask, "HashPosTask");
+  printElapsedTime(simulation, Simulation::PerfMarker::Summing, "Summing");
+  printElapsedTime(simulation, Simulation::PerfMarker::NeighborStencil, "NeighborStencil");
+  printElapsedTime(simulation, Simulation::PerfMarker::RulesCalc, "RulesCalc");
+  printElapsedTime(simulation, Simulation::PerfMarker::Transform, "Transform");
+  printElapsedTime(simulation, Simulation::PerfMarker::Rebin, "Rebin");
+  printElapsedTime(simulation, Simulation::PerfMarker::Export, "Export");
+  printElapsedTime(simulation, Simulation::PerfMarker::Total, "Total");
+  std::cout << "\n";
+  printElapsedTime(simulation, Simulation::PerfMarker::ObstacleAvoidanceTask, "ObstacleAvoidanceTask");
+  printElapsedTime(simulation, Simulation::PerfMarker::FlowFieldTask, "FlowFieldTask");
+
+  simulation.deinit();
 
   return 0;
 }
-